@@ -0,0 +1,39 @@
+// access_log.cc
+// Machine-readable per-access log of the MMU
+// Author: Hank Bao
+
+#include <cstdlib>
+
+#include "access_log.h"
+
+AccessLog::AccessLog(const std::string& path, LogFormat format) : format_{format}, writer_{path} {
+    if (format_ == LogFormat::Csv) {
+        writer_.put_str("kind,result,vaddr,vpn,pfn,paddr,cost\n");
+    }
+}
+
+auto AccessLog::append(const AccessRecord& record) -> void {
+    switch (format_) {
+        case LogFormat::Binary:
+            writer_.write(&record, sizeof(record));
+            break;
+
+        case LogFormat::Csv:
+            writer_.put_str(record.prefetch ? "prefetch," : "access,");
+            writer_.put_str(record.hit ? "HIT," : "MISS,");
+            writer_.put_hex(record.vaddr);
+            writer_.put_char(',');
+            writer_.put_uint(record.vpn);
+            writer_.put_char(',');
+            writer_.put_uint(record.pfn);
+            writer_.put_char(',');
+            writer_.put_hex(record.paddr);
+            writer_.put_char(',');
+            writer_.put_uint(record.cost);
+            writer_.put_char('\n');
+            break;
+
+        default:
+            std::abort();
+    }
+}
@@ -0,0 +1,43 @@
+// access_log.h
+// Machine-readable per-access log of the MMU
+// Author: Hank Bao
+
+#pragma once
+
+#include <string>
+
+#include "buffered_writer.h"
+#include "def.h"
+
+enum class LogFormat {
+    Csv,
+    Binary,
+};
+
+// one record per MMU access, also the layout of the binary log
+struct AccessRecord {
+    uint64_t vaddr;
+    uint64_t vpn;
+    uint64_t pfn;
+    uint64_t paddr;
+    uint32_t cost;
+    uint8_t hit;
+    uint8_t prefetch;
+    uint16_t reserved;
+};
+
+class AccessLog {
+   public:
+    AccessLog(const std::string& path, LogFormat format);
+    ~AccessLog() = default;
+
+    auto append(const AccessRecord& record) -> void;
+
+   private:
+    const LogFormat format_;
+    BufferedWriter writer_;
+
+   private:
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+};
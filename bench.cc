@@ -0,0 +1,188 @@
+// bench.cc
+// Throughput benchmarks of the TLB levels, policies and hierarchies
+// Author: Hank Bao
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "hierarchy.h"
+#include "level_stats.h"
+#include "rng.h"
+
+// every benchmark runs this many operations, the best of kRounds rounds is kept
+static constexpr size_t kOps = 1 << 20;
+static constexpr int kRounds = 3;
+static constexpr uint64_t kSeed = 42;
+
+static const Policy kPolicies[] = {Policy::FIFO, Policy::LRU, Policy::Random, Policy::Clock, Policy::Plru,
+                                   Policy::Srrip, Policy::Brrip, Policy::Drrip, Policy::Lfu};
+static const uint32_t kSizes[] = {64, 512, 2048};
+static const uint32_t kWays[] = {0, 8};
+
+// heap allocations so far, counted by the replaced global operator new
+static uint64_t allocations = 0;
+
+auto operator new(size_t size) -> void* {
+    allocations += 1;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+auto operator new[](size_t size) -> void* {
+    return operator new(size);
+}
+
+auto operator delete(void* p) noexcept -> void {
+    std::free(p);
+}
+
+auto operator delete[](void* p) noexcept -> void {
+    std::free(p);
+}
+
+auto operator delete(void* p, size_t) noexcept -> void {
+    std::free(p);
+}
+
+auto operator delete[](void* p, size_t) noexcept -> void {
+    std::free(p);
+}
+
+struct Measure {
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+// time body(), which runs kOps operations, and count its allocations
+template <typename Body>
+static auto measure(Body&& body) -> Measure {
+    Measure best{0, 0};
+    for (int round = 0; round < kRounds; ++round) {
+        uint64_t allocated = allocations;
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        Measure m{elapsed / kOps, (allocations - allocated) / (double)kOps};
+        if (round == 0 || m.ns_per_op < best.ns_per_op) {
+            best = m;
+        }
+    }
+    return best;
+}
+
+// kOps page numbers drawn uniformly from pages distinct ones
+static auto make_stream(uint64_t pages, uint64_t seed) -> std::vector<page_type> {
+    Rng rng{seed};
+    std::vector<page_type> stream(kOps);
+    for (auto& vpn : stream) {
+        vpn = rng.next() % pages;
+    }
+    return stream;
+}
+
+static auto report(const std::string& name, const LevelConfig& level, size_t depth, const Measure& m) -> void {
+    std::printf("%-8s %-6s %6u %4u %5zu %10zu %10.2f %10.2f %8.4f\n", name.c_str(), policy_to_string(level.policy).c_str(),
+                level.size, level.ways, depth, kOps, m.ns_per_op, 1e3 / m.ns_per_op, m.allocs_per_op);
+}
+
+// single levels built as TlbImpl, looked up on a working set they hold and
+// filled with pages they never saw
+static auto bench_levels(const std::string& filter) -> void {
+    for (auto policy : kPolicies) {
+        for (auto size : kSizes) {
+            for (auto ways : kWays) {
+                LevelConfig level{size, ways, 5, policy};
+
+                if (std::string{"lookup"}.find(filter) != std::string::npos) {
+                    auto tlb = make_hierarchy({level}, kSeed, true);
+                    for (page_type vpn = 0; vpn < size; ++vpn) {
+                        tlb->insert(vpn, vpn, true);
+                    }
+                    auto stream = make_stream(size, kSeed);
+                    uint64_t hits = 0;
+                    auto m = measure([&] {
+                        for (auto vpn : stream) {
+                            hits += tlb->lookup(vpn).has_value();
+                        }
+                    });
+                    if (hits == 0) {
+                        std::fprintf(stderr, "No hits in lookup benchmark\n");
+                    }
+                    report("lookup", level, 1, m);
+                }
+
+                if (std::string{"insert"}.find(filter) != std::string::npos) {
+                    auto tlb = make_hierarchy({level}, kSeed, true);
+                    page_type next = 0;
+                    auto m = measure([&] {
+                        for (size_t i = 0; i < kOps; ++i, ++next) {
+                            tlb->insert(next, next, true);
+                        }
+                    });
+                    report("insert", level, 1, m);
+                }
+            }
+        }
+    }
+}
+
+// whole MMUs of one to three levels, 64 then 512 then 2048 entries of the
+// same policy and ways, on a working set twice the size of the last level
+static auto bench_hierarchies(const std::string& filter) -> void {
+    if (std::string{"access"}.find(filter) == std::string::npos) {
+        return;
+    }
+
+    for (auto policy : kPolicies) {
+        for (auto ways : kWays) {
+            std::vector<LevelConfig> levels{};
+            for (size_t depth = 1; depth <= 3; ++depth) {
+                levels.push_back(LevelConfig{kSizes[depth - 1], ways, depth == 1 ? 5u : 20u, policy});
+
+                MmuConfig config{4096, 100, levels, kSeed};
+                auto mmu = make_mmu(config);
+                mmu->set_verbose(false);
+
+                auto stream = make_stream(2 * kSizes[depth - 1], kSeed + depth);
+                for (auto& vpn : stream) {
+                    vpn <<= 12;
+                }
+                uint64_t cost = 0;
+                auto m = measure([&] {
+                    for (auto vaddr : stream) {
+                        cost += mmu->access(vaddr, false).second;
+                    }
+                });
+                if (cost == 0) {
+                    std::fprintf(stderr, "No cost in access benchmark\n");
+                }
+                report("access", levels.back(), depth, m);
+            }
+        }
+    }
+}
+
+// Usage: tlb_bench [FILTER], running the benchmarks whose name contains FILTER.
+// One line per benchmark, in a fixed order and format, so the output of two
+// builds can be compared line by line.
+auto main(int argc, char** argv) -> int {
+    std::string filter = argc > 1 ? argv[1] : "";
+
+    // the per-level counters are part of every operation timed when built in
+    std::printf("# level stats %s\n", kLevelStats ? "compiled in" : "compiled out");
+    std::printf("%-8s %-6s %6s %4s %5s %10s %10s %10s %8s\n", "bench", "policy", "size", "ways", "depth", "ops",
+                "ns/op", "Mops/s", "allocs/op");
+    bench_levels(filter);
+    bench_hierarchies(filter);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+// block_window.h
+// Ring of address blocks decoded once and read by several threads
+// Author: Hank Bao
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "def.h"
+
+// addresses per block and blocks alive at once
+constexpr size_t kBlockSize = 64 * 1024;
+constexpr size_t kWindow = 4;
+
+// A ring of blocks filled by one producer and read by every consumer; a
+// block is refilled only after all consumers have released it.
+class BlockWindow {
+   public:
+    BlockWindow(size_t consumers) : blocks_(kWindow), consumed_(consumers, 0), published_{0}, done_{false} {}
+    ~BlockWindow() = default;
+
+    // the block to fill next, waits for the slowest consumer if the window is full
+    auto claim() -> std::vector<addr_type>& {
+        std::unique_lock<std::mutex> lock{mutex_};
+        cv_.wait(lock, [this] {
+            return published_ - *std::min_element(consumed_.begin(), consumed_.end()) < kWindow;
+        });
+
+        return blocks_[published_ % kWindow];
+    }
+
+    auto publish() -> void {
+        std::lock_guard<std::mutex> lock{mutex_};
+        published_ += 1;
+        cv_.notify_all();
+    }
+
+    auto finish() -> void {
+        std::lock_guard<std::mutex> lock{mutex_};
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    // the block seq, or nullptr once the stream is over
+    auto acquire(size_t seq) -> const std::vector<addr_type>* {
+        std::unique_lock<std::mutex> lock{mutex_};
+        cv_.wait(lock, [this, seq] { return seq < published_ || done_; });
+
+        return seq < published_ ? &blocks_[seq % kWindow] : nullptr;
+    }
+
+    auto release(size_t consumer, size_t seq) -> void {
+        std::lock_guard<std::mutex> lock{mutex_};
+        consumed_[consumer] = seq + 1;
+        cv_.notify_all();
+    }
+
+    // fill the window from source until it runs dry, on the calling thread,
+    // source(buffer, max) returning how many addresses it wrote
+    template <typename Source>
+    auto produce(const Source& source) -> void {
+        for (;;) {
+            auto& block = claim();
+            block.resize(kBlockSize);
+            block.resize(source(block.data(), kBlockSize));
+            if (block.empty()) {
+                finish();
+                break;
+            }
+            publish();
+        }
+    }
+
+   private:
+    std::vector<std::vector<addr_type>> blocks_;
+    std::vector<size_t> consumed_;
+    size_t published_;
+    bool done_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+   private:
+    BlockWindow(const BlockWindow&) = delete;
+    BlockWindow& operator=(const BlockWindow&) = delete;
+};
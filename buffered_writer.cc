@@ -0,0 +1,94 @@
+// buffered_writer.cc
+// Block-buffered output stream for machine-readable reports
+// Author: Hank Bao
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "buffered_writer.h"
+
+BufferedWriter::BufferedWriter(const std::string& path, size_t capacity)
+    : file_{nullptr}, buffer_(capacity), capacity_{capacity}, used_{0} {
+    file_ = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        std::fprintf(stderr, "Cannot open %s: %s\n", path.c_str(), std::strerror(errno));
+        ::exit(EXIT_FAILURE);
+    }
+
+    // the buffer above already batches everything
+    if (file_ != stdout) {
+        std::setvbuf(file_, nullptr, _IONBF, 0);
+    }
+}
+
+BufferedWriter::~BufferedWriter() {
+    flush();
+
+    if (file_ != stdout) {
+        std::fclose(file_);
+    }
+}
+
+auto BufferedWriter::write(const void* data, size_t size) -> void {
+    if (size > capacity_) {
+        // too large to batch, pass it through
+        flush();
+        std::fwrite(data, 1, size, file_);
+        return;
+    }
+
+    std::memcpy(reserve(size), data, size);
+    used_ += size;
+}
+
+auto BufferedWriter::put_char(char c) -> void {
+    *reserve(1) = c;
+    used_ += 1;
+}
+
+auto BufferedWriter::put_uint(uint64_t n) -> void {
+    char digits[20];
+    int len = 0;
+    do {
+        digits[len++] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    } while (n != 0);
+
+    char* p = reserve(len);
+    for (int i = 0; i < len; ++i) {
+        p[i] = digits[len - 1 - i];
+    }
+    used_ += len;
+}
+
+auto BufferedWriter::put_hex(uint64_t n) -> void {
+    static const char kHex[] = "0123456789abcdef";
+
+    char digits[16];
+    int len = 0;
+    do {
+        digits[len++] = kHex[n & 0xf];
+        n >>= 4;
+    } while (n != 0);
+
+    char* p = reserve(len + 2);
+    p[0] = '0';
+    p[1] = 'x';
+    for (int i = 0; i < len; ++i) {
+        p[i + 2] = digits[len - 1 - i];
+    }
+    used_ += len + 2;
+}
+
+auto BufferedWriter::put_str(const char* s) -> void {
+    write(s, std::strlen(s));
+}
+
+auto BufferedWriter::flush() -> void {
+    if (used_ > 0) {
+        std::fwrite(buffer_.data(), 1, used_, file_);
+        used_ = 0;
+    }
+    std::fflush(file_);
+}
@@ -0,0 +1,46 @@
+// buffered_writer.h
+// Block-buffered output stream for machine-readable reports
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Collects output in a large in-memory block and hands it to the OS only
+// when the block is full, keeping the simulation loop free of I/O calls.
+class BufferedWriter {
+   public:
+    BufferedWriter(const std::string& path, size_t capacity = kDefaultCapacity);
+    ~BufferedWriter();
+
+    auto write(const void* data, size_t size) -> void;
+    auto put_char(char c) -> void;
+    auto put_uint(uint64_t n) -> void;
+    auto put_hex(uint64_t n) -> void;
+    auto put_str(const char* s) -> void;
+    auto flush() -> void;
+
+    static constexpr size_t kDefaultCapacity = 1 << 20;
+
+   private:
+    auto reserve(size_t size) -> char* {
+        if (capacity_ - used_ < size) {
+            flush();
+        }
+        return buffer_.data() + used_;
+    }
+
+   private:
+    std::FILE* file_;
+    std::vector<char> buffer_;
+    const size_t capacity_;
+    size_t used_;
+
+   private:
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+};
@@ -4,12 +4,66 @@
 
 #pragma once
 
+#include <cstdint>
 #include <utility>
 #include <unistd.h>
 
-typedef uint32_t addr_type;
+typedef uint64_t addr_type;
 typedef uint32_t size_type;
 typedef uint32_t time_type;
+// a virtual or physical page number
+typedef uint64_t page_type;
+
+// an address-space ID, as a PCID on x86
+typedef uint32_t asid_type;
 
 // <pfn, valid>
-typedef std::pair<size_type, bool> TlbEntry;
+typedef std::pair<page_type, bool> TlbEntry;
+
+// Cached page numbers carry the ASID of their address space in the bits
+// above the widest VPN, that of 4K pages of 64-bit addresses, so no page
+// may be smaller.
+constexpr size_type kAsidBits = 12;
+constexpr size_type kAsidShift = 52;
+constexpr uint32_t kMinPageSize = uint32_t{1} << (64 - kAsidShift);
+
+inline auto tag_page(page_type vpn, asid_type asid) -> page_type {
+    return vpn | (static_cast<page_type>(asid) << kAsidShift);
+}
+
+inline auto untag_page(page_type key) -> page_type {
+    return key & ((page_type{1} << kAsidShift) - 1);
+}
+
+// A context switch travels in the address stream as a record of its own: a
+// non-canonical address with kSwitchMark in its top 16 bits and the ASID
+// switched to in its low bits.
+constexpr addr_type kSwitchMark = 0xa5a5;
+
+inline auto is_context_switch(addr_type addr) -> bool {
+    return (addr >> 48) == kSwitchMark;
+}
+
+inline auto context_switch(asid_type asid) -> addr_type {
+    return (kSwitchMark << 48) | asid;
+}
+
+inline auto switch_asid(addr_type addr) -> asid_type {
+    return static_cast<asid_type>(addr & 0xffffffff);
+}
+
+// So does an unmap, with kUnmapMark and the unmapped address in its low 48 bits.
+constexpr addr_type kUnmapMark = 0xa5a6;
+constexpr addr_type kUnmapAddressMask = (addr_type{1} << 48) - 1;
+
+inline auto is_unmap(addr_type addr) -> bool {
+    return (addr >> 48) == kUnmapMark;
+}
+
+inline auto unmap(addr_type vaddr) -> addr_type {
+    return (kUnmapMark << 48) | (vaddr & kUnmapAddressMask);
+}
+
+inline auto unmap_address(addr_type addr) -> addr_type {
+    return addr & kUnmapAddressMask;
+}
@@ -0,0 +1,307 @@
+// generator.cc
+// Synthetic reference streams generated on the fly
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "generator.h"
+#include "utils.h"
+
+class GeneratorUniform : public Generator {
+   public:
+    GeneratorUniform(uint64_t pages, size_type page_size, uint64_t seed)
+        : pages_{pages}, page_size_{page_size}, rng_{seed} {}
+
+    virtual auto next() -> addr_type override { return (rng_.next() % pages_) * page_size_; }
+
+   private:
+    const uint64_t pages_;
+    const size_type page_size_;
+    Rng rng_;
+};
+
+// Rejection-inversion sampling (Hörmann and Derflinger), constant time and
+// memory however many pages there are.
+class GeneratorZipf : public Generator {
+   public:
+    GeneratorZipf(uint64_t pages, double alpha, size_type page_size, uint64_t seed)
+        : pages_{pages},
+          alpha_{alpha},
+          page_size_{page_size},
+          rng_{seed},
+          h_first_{h_integral(1.5) - 1.0},
+          h_last_{h_integral(pages + 0.5)},
+          s_{2.0 - h_integral_inverse(h_integral(2.5) - h(2.0))} {}
+
+    virtual auto next() -> addr_type override {
+        for (;;) {
+            double u = h_last_ + rng_.uniform() * (h_first_ - h_last_);
+            double x = h_integral_inverse(u);
+            auto k = static_cast<uint64_t>(std::max(1.0, std::min(x + 0.5, static_cast<double>(pages_))));
+            if (k - x <= s_ || u >= h_integral(k + 0.5) - h(static_cast<double>(k))) {
+                return (k - 1) * page_size_;
+            }
+        }
+    }
+
+   private:
+    // log1p(x) / x and expm1(x) / x, by their series near 0
+    static auto helper1(double x) -> double {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    static auto helper2(double x) -> double {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+
+    auto h(double x) const -> double { return std::exp(-alpha_ * std::log(x)); }
+    auto h_integral(double x) const -> double {
+        double log_x = std::log(x);
+        return helper2((1.0 - alpha_) * log_x) * log_x;
+    }
+    auto h_integral_inverse(double x) const -> double {
+        double t = std::max(x * (1.0 - alpha_), -1.0);
+        return std::exp(helper1(t) * x);
+    }
+
+   private:
+    const uint64_t pages_;
+    const double alpha_;
+    const size_type page_size_;
+    Rng rng_;
+    const double h_first_;
+    const double h_last_;
+    const double s_;
+};
+
+class GeneratorStride : public Generator {
+   public:
+    GeneratorStride(uint64_t pages, uint64_t stride, size_type page_size, uint64_t seed)
+        : span_{pages * page_size}, stride_{stride}, offset_{(Rng{seed}.next() % pages) * page_size} {}
+
+    virtual auto next() -> addr_type override {
+        auto addr = offset_;
+        offset_ = (offset_ + stride_) % span_;
+        return addr;
+    }
+
+   private:
+    const uint64_t span_;
+    const uint64_t stride_;
+    uint64_t offset_;
+};
+
+class GeneratorLoop : public Generator {
+   public:
+    GeneratorLoop(uint64_t pages, size_type page_size, uint64_t seed)
+        : pages_{pages}, page_size_{page_size}, page_{Rng{seed}.next() % pages} {}
+
+    virtual auto next() -> addr_type override {
+        auto addr = page_ * page_size_;
+        page_ = page_ + 1 == pages_ ? 0 : page_ + 1;
+        return addr;
+    }
+
+   private:
+    const uint64_t pages_;
+    const size_type page_size_;
+    uint64_t page_;
+};
+
+// A full-period LCG modulo the power of 2 above the pages, skipping the
+// values beyond them, visits every page once per lap in a scrambled order
+// without keeping the permutation.
+class GeneratorChase : public Generator {
+   public:
+    GeneratorChase(uint64_t pages, size_type page_size, uint64_t seed)
+        : pages_{pages}, page_size_{page_size}, mask_{mask_above(pages)}, increment_{0}, page_{0} {
+        Rng rng{seed};
+        increment_ = rng.next() | 1;
+        page_ = rng.next() % pages;
+    }
+
+    virtual auto next() -> addr_type override {
+        auto addr = page_ * page_size_;
+        do {
+            // a multiplier of 1 mod 4 and an odd increment give the full period
+            page_ = (page_ * 0x5851f42d4c957f2dull + increment_) & mask_;
+        } while (page_ >= pages_);
+        return addr;
+    }
+
+   private:
+    static auto mask_above(uint64_t pages) -> uint64_t {
+        uint64_t mask = 1;
+        while (mask < pages) {
+            mask = mask << 1 | 1;
+        }
+        return mask;
+    }
+
+   private:
+    const uint64_t pages_;
+    const size_type page_size_;
+    const uint64_t mask_;
+    uint64_t increment_;
+    uint64_t page_;
+};
+
+static auto kind_to_string(GeneratorKind kind) -> std::string {
+    switch (kind) {
+        case GeneratorKind::Uniform:
+            return "uniform";
+        case GeneratorKind::Zipf:
+            return "zipf";
+        case GeneratorKind::Stride:
+            return "stride";
+        case GeneratorKind::Loop:
+            return "loop";
+        case GeneratorKind::Chase:
+            return "chase";
+        default:
+            std::abort();
+    }
+}
+
+auto generator_to_string(const GeneratorConfig& gen) -> std::string {
+    std::string str = kind_to_string(gen.kind) + ":" + std::to_string(gen.count) + ":" + std::to_string(gen.pages);
+    if (gen.kind == GeneratorKind::Stride) {
+        str += ":" + std::to_string(gen.stride);
+    } else if (gen.kind == GeneratorKind::Zipf) {
+        char alpha[32];
+        std::snprintf(alpha, sizeof(alpha), "%g", gen.alpha);
+        str += std::string{":"} + alpha;
+    }
+    if (gen.seeded) {
+        str += ":" + std::to_string(gen.seed);
+    }
+    return str;
+}
+
+auto parse_generator(const std::string& str) -> GeneratorConfig {
+    auto fields = split_string(str, ":");
+
+    GeneratorConfig gen{GeneratorKind::Uniform, 0, 0};
+    size_t params = 0;
+    if (fields[0] == "uniform") {
+        gen.kind = GeneratorKind::Uniform;
+    } else if (fields[0] == "zipf") {
+        gen.kind = GeneratorKind::Zipf;
+        params = 1;
+    } else if (fields[0] == "stride") {
+        gen.kind = GeneratorKind::Stride;
+        params = 1;
+    } else if (fields[0] == "loop") {
+        gen.kind = GeneratorKind::Loop;
+    } else if (fields[0] == "chase") {
+        gen.kind = GeneratorKind::Chase;
+    } else {
+        std::fprintf(stderr, "Invalid generator: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    if (fields.size() < 3 + params || fields.size() > 4 + params) {
+        std::fprintf(stderr, "Invalid generator: %s\n", str.c_str());
+        print_usage(true);
+    }
+    for (size_t i = 1; i < fields.size(); ++i) {
+        if (fields[i].empty()) {
+            std::fprintf(stderr, "Invalid generator: %s\n", str.c_str());
+            print_usage(true);
+        }
+    }
+
+    gen.count = str_to_num(fields[1]);
+    gen.pages = str_to_num(fields[2]);
+    if (gen.pages == 0) {
+        std::fprintf(stderr, "Invalid generator pages: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    if (gen.kind == GeneratorKind::Stride) {
+        gen.stride = str_to_num(fields[3]);
+    } else if (gen.kind == GeneratorKind::Zipf) {
+        char* end = nullptr;
+        gen.alpha = std::strtod(fields[3].c_str(), &end);
+        if (*end != '\0' || !(gen.alpha > 0)) {
+            std::fprintf(stderr, "Invalid Zipf skew: %s\n", fields[3].c_str());
+            print_usage(true);
+        }
+    }
+
+    if (fields.size() == 4 + params) {
+        gen.seed = parse_seed(fields.back());
+        gen.seeded = true;
+    }
+
+    return gen;
+}
+
+auto parse_rounds(const std::string& str) -> uint64_t {
+    uint64_t rounds = str_to_num(str);
+    if (rounds == 0) {
+        std::fprintf(stderr, "Invalid generator rounds: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return rounds;
+}
+
+auto make_generator(const GeneratorConfig& gen, size_type page_size, uint64_t seed) -> std::unique_ptr<Generator> {
+    switch (gen.kind) {
+        case GeneratorKind::Uniform:
+            return std::make_unique<GeneratorUniform>(gen.pages, page_size, seed);
+        case GeneratorKind::Zipf:
+            return std::make_unique<GeneratorZipf>(gen.pages, gen.alpha, page_size, seed);
+        case GeneratorKind::Stride:
+            return std::make_unique<GeneratorStride>(gen.pages, gen.stride, page_size, seed);
+        case GeneratorKind::Loop:
+            return std::make_unique<GeneratorLoop>(gen.pages, page_size, seed);
+        case GeneratorKind::Chase:
+            return std::make_unique<GeneratorChase>(gen.pages, page_size, seed);
+        default:
+            std::abort();
+    }
+}
+
+Workload::Workload(const std::vector<GeneratorConfig>& phases, uint64_t rounds, size_type page_size, uint64_t seed)
+    : phases_{phases}, rounds_{rounds}, generators_{}, phase_{0}, round_{0}, left_{0} {
+    for (size_t i = 0; i < phases_.size(); ++i) {
+        const auto& gen = phases_[i];
+        generators_.push_back(make_generator(gen, page_size, gen.seeded ? gen.seed : seed + i));
+    }
+
+    left_ = phases_.empty() ? 0 : phases_[0].count;
+}
+
+auto Workload::read(addr_type* addrs, size_t max) -> size_t {
+    size_t n = 0;
+    while (n < max) {
+        if (left_ == 0) {
+            // the next phase with anything to generate
+            if (round_ == rounds_ || phases_.empty()) {
+                break;
+            }
+            if (++phase_ == phases_.size()) {
+                phase_ = 0;
+                if (++round_ == rounds_) {
+                    break;
+                }
+            }
+            left_ = phases_[phase_].count;
+            continue;
+        }
+
+        auto& generator = *generators_[phase_];
+        size_t batch = static_cast<size_t>(std::min<uint64_t>(max - n, left_));
+        for (size_t i = 0; i < batch; ++i) {
+            addrs[n + i] = kBase + generator.next();
+        }
+        n += batch;
+        left_ -= batch;
+    }
+
+    return n;
+}
@@ -0,0 +1,80 @@
+// generator.h
+// Synthetic reference streams generated on the fly
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "def.h"
+#include "rng.h"
+
+enum class GeneratorKind {
+    Uniform,  // pages drawn uniformly
+    Zipf,     // pages drawn with Zipfian popularity, the first the most popular
+    Stride,   // a scan stepping STRIDE bytes, wrapping around the pages
+    Loop,     // the pages in order, over and over
+    Chase,    // every page once per lap in a random order, as a pointer chase
+};
+
+// one phase of a workload, COUNT accesses over PAGES pages
+struct GeneratorConfig {
+    GeneratorKind kind;
+    uint64_t count;
+    uint64_t pages;
+    uint64_t stride = 0;  // Stride only, in bytes
+    double alpha = 0;     // Zipf only, the skew
+    uint64_t seed = 0;
+    bool seeded = false;  // the seed given, or derived from --seed
+};
+
+// KIND:COUNT:PAGES[:STRIDE|ALPHA][:SEED]
+auto generator_to_string(const GeneratorConfig& gen) -> std::string;
+auto parse_generator(const std::string& str) -> GeneratorConfig;
+auto parse_rounds(const std::string& str) -> uint64_t;
+
+// the offsets from the base of the workload of an endless stream
+class Generator {
+   public:
+    Generator() = default;
+    virtual ~Generator() = default;
+
+    virtual auto next() -> addr_type = 0;
+
+   private:
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+};
+
+auto make_generator(const GeneratorConfig& gen, size_type page_size, uint64_t seed) -> std::unique_ptr<Generator>;
+
+// The phases one after another, every round, all from address kBase up.
+// Addresses are produced as they are read, so a stream of any length takes
+// no memory; phases without a seed of their own are seeded with the seed
+// plus their index.
+class Workload {
+   public:
+    static constexpr addr_type kBase = 0x10000000;
+
+    Workload(const std::vector<GeneratorConfig>& phases, uint64_t rounds, size_type page_size, uint64_t seed);
+    ~Workload() = default;
+
+    // fetch up to max addresses, returns how many, 0 once every round is over
+    auto read(addr_type* addrs, size_t max) -> size_t;
+
+   private:
+    const std::vector<GeneratorConfig> phases_;
+    const uint64_t rounds_;
+    std::vector<std::unique_ptr<Generator>> generators_;
+    size_t phase_;
+    uint64_t round_;
+    uint64_t left_;  // accesses left in the phase
+
+   private:
+    Workload(const Workload&) = delete;
+    Workload& operator=(const Workload&) = delete;
+};
@@ -0,0 +1,494 @@
+// hierarchy.cc
+// Construction of TLB hierarchies and MMUs from their configuration
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+
+#include "hierarchy.h"
+#include "policy_clock.h"
+#include "policy_fifo.h"
+#include "policy_lfu.h"
+#include "policy_lru.h"
+#include "policy_plru.h"
+#include "policy_rand.h"
+#include "policy_rrip.h"
+#include "tlb_chain.h"
+#include "tlb_impl.h"
+#include "tlb_null.h"
+#include "tlb_shared.h"
+
+auto level_to_string(const LevelConfig& level) -> std::string {
+    auto str = std::to_string(level.size) + ":" + std::to_string(level.cost) + ":" + policy_to_string(level.policy);
+    if (level.ways != 0) {
+        str += ":" + std::to_string(level.ways);
+    }
+    if (level.shared) {
+        str += ":shared";
+    }
+
+    return str;
+}
+
+auto parse_level(const std::string& str) -> LevelConfig {
+    auto fields = split_string(str, ":");
+    if (fields.size() < 3 || fields.size() > 5) {
+        std::fprintf(stderr, "Invalid level: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    LevelConfig level{parse_tlb_size(fields[0]), 0, parse_cost(fields[1]), parse_policy(fields[2])};
+    for (size_t i = 3; i < fields.size(); ++i) {
+        if (fields[i] == "shared") {
+            level.shared = true;
+        } else if (i == 3) {
+            level.ways = parse_ways(fields[i]);
+        } else {
+            std::fprintf(stderr, "Invalid level: %s\n", str.c_str());
+            print_usage(true);
+        }
+    }
+    level.ways = resolve_ways(level.size, level.ways, 0);
+
+    return level;
+}
+
+// the non-blank lines of a configuration file without their comments
+static auto read_config_lines(const std::string& path, const char* what) -> std::vector<std::string> {
+    std::ifstream file{path};
+    if (!file) {
+        std::fprintf(stderr, "Cannot open %s %s\n", what, path.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+
+    std::vector<std::string> lines{};
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+
+        // trim blanks on both ends
+        auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            continue;
+        }
+        auto last = line.find_last_not_of(" \t\r");
+        lines.push_back(line.substr(first, last - first + 1));
+    }
+
+    return lines;
+}
+
+auto parse_hierarchy_file(const std::string& path) -> std::vector<LevelConfig> {
+    std::vector<LevelConfig> levels{};
+    for (const auto& line : read_config_lines(path, "hierarchy")) {
+        levels.push_back(parse_level(line));
+    }
+
+    return levels;
+}
+
+auto validate_levels(const std::vector<LevelConfig>& levels) -> void {
+    for (size_t i = 0; i + 1 < levels.size(); ++i) {
+        if (levels[i].shared) {
+            std::fprintf(stderr, "Only the last level can be shared: %s\n", level_to_string(levels[i]).c_str());
+            print_usage(true);
+        }
+    }
+}
+
+auto region_to_string(const RegionConfig& region) -> std::string {
+    return num_to_str_hex(region.start) + ":" + num_to_str_hex(region.length) + ":" + std::to_string(region.page_size);
+}
+
+auto parse_region(const std::string& str) -> RegionConfig {
+    auto fields = split_string(str, ":");
+    if (fields.size() != 3 || fields[0].empty() || fields[1].empty()) {
+        std::fprintf(stderr, "Invalid region: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return RegionConfig{str_to_num(fields[0]), str_to_num(fields[1]), parse_page_size(fields[2])};
+}
+
+auto parse_pagemap_file(const std::string& path) -> std::vector<RegionConfig> {
+    std::vector<RegionConfig> regions{};
+    for (const auto& line : read_config_lines(path, "page map")) {
+        regions.push_back(parse_region(line));
+    }
+
+    return regions;
+}
+
+auto validate_regions(const std::vector<RegionConfig>& regions) -> void {
+    for (const auto& region : regions) {
+        uint64_t mask = region.page_size - 1;
+        bool valid = region.length != 0 && (region.start & mask) == 0 && (region.length & mask) == 0 &&
+                     region.length - 1 <= UINT64_MAX - region.start;
+        if (!valid) {
+            std::fprintf(stderr, "Invalid region: %s\n", region_to_string(region).c_str());
+            print_usage(true);
+        }
+    }
+
+    auto sorted = regions;
+    std::sort(sorted.begin(), sorted.end(), [](const RegionConfig& a, const RegionConfig& b) { return a.start < b.start; });
+    for (size_t i = 1; i < sorted.size(); ++i) {
+        if (sorted[i].start - sorted[i - 1].start < sorted[i - 1].length) {
+            std::fprintf(stderr, "Overlapping regions: %s and %s\n", region_to_string(sorted[i - 1]).c_str(),
+                         region_to_string(sorted[i]).c_str());
+            print_usage(true);
+        }
+    }
+}
+
+auto page_tlb_to_string(const PageTlbConfig& page_tlb) -> std::string {
+    return std::to_string(page_tlb.page_size) + ":" + level_to_string(page_tlb.level);
+}
+
+auto parse_page_tlb(const std::string& str) -> PageTlbConfig {
+    auto colon = str.find(':');
+    if (colon == std::string::npos || colon == 0) {
+        std::fprintf(stderr, "Invalid page tlb: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    auto level = parse_level(str.substr(colon + 1));
+    if (level.shared) {
+        std::fprintf(stderr, "A page tlb cannot be shared: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return PageTlbConfig{parse_page_size(str.substr(0, colon)), level};
+}
+
+auto walk_to_string(const WalkConfig& walk) -> std::string {
+    if (walk.levels == 0) {
+        return "flat";
+    }
+
+    return std::to_string(walk.levels) + ":" + std::to_string(walk.pwc_entries) + ":" + std::to_string(walk.cache_lines);
+}
+
+auto parse_walk(const std::string& str, WalkConfig& walk) -> void {
+    auto fields = split_string(str, ":");
+    if (fields.size() > 3 || fields[0].empty()) {
+        std::fprintf(stderr, "Invalid walk: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    uint64_t levels = str_to_num(fields[0]);
+    if (levels != 0 && levels != 4 && levels != 5) {
+        std::fprintf(stderr, "Invalid page table levels: %s\n", fields[0].c_str());
+        print_usage(true);
+    }
+    walk.levels = static_cast<uint32_t>(levels);
+    if (fields.size() > 1) {
+        walk.pwc_entries = parse_tlb_size(fields[1]);
+    }
+    if (fields.size() > 2) {
+        walk.cache_lines = parse_tlb_size(fields[2]);
+        if ((walk.cache_lines & (walk.cache_lines - 1)) != 0) {
+            std::fprintf(stderr, "Invalid page table cache lines: %s\n", fields[2].c_str());
+            print_usage(true);
+        }
+    }
+}
+
+auto parse_walk_costs(const std::string& str, WalkConfig& walk) -> void {
+    auto fields = split_string(str, ":");
+    if (fields.size() != 2) {
+        std::fprintf(stderr, "Invalid walk costs: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    walk.pwc_cost = parse_cost(fields[0]);
+    walk.cache_cost = parse_cost(fields[1]);
+}
+
+auto parse_fault_costs(const std::string& str, MemoryConfig& memory) -> void {
+    auto fields = split_string(str, ":");
+    if (fields.size() > 2 || fields[0].empty()) {
+        std::fprintf(stderr, "Invalid fault costs: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    memory.minor_cost = parse_cost(fields[0]);
+    if (fields.size() > 1) {
+        memory.major_cost = parse_cost(fields[1]);
+    }
+}
+
+auto prefetcher_to_string(const PrefetchConfig& prefetch) -> std::string {
+    switch (prefetch.kind) {
+        case PrefetchKind::None:
+            return "none";
+        case PrefetchKind::Sequential:
+            return "seq:" + std::to_string(prefetch.degree);
+        case PrefetchKind::Stride:
+            return "stride:" + std::to_string(prefetch.degree);
+        case PrefetchKind::Distance:
+            return "distance";
+        default:
+            std::abort();
+    }
+}
+
+auto parse_prefetcher(const std::string& str, PrefetchConfig& prefetch) -> void {
+    auto fields = split_string(str, ":");
+    if (fields.size() > 2) {
+        std::fprintf(stderr, "Invalid prefetcher: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    if (fields[0] == "none") {
+        prefetch.kind = PrefetchKind::None;
+    } else if (fields[0] == "seq") {
+        prefetch.kind = PrefetchKind::Sequential;
+    } else if (fields[0] == "stride") {
+        prefetch.kind = PrefetchKind::Stride;
+    } else if (fields[0] == "distance") {
+        prefetch.kind = PrefetchKind::Distance;
+    } else {
+        std::fprintf(stderr, "Invalid prefetcher: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    if (fields.size() > 1) {
+        uint64_t degree = fields[1].empty() ? 0 : str_to_num(fields[1]);
+        if (degree == 0 || degree > 64) {
+            std::fprintf(stderr, "Invalid prefetch degree: %s\n", fields[1].c_str());
+            print_usage(true);
+        }
+        prefetch.degree = static_cast<uint32_t>(degree);
+    }
+}
+
+auto parse_prefetch_buffer(const std::string& str, PrefetchConfig& prefetch) -> void {
+    auto fields = split_string(str, ":");
+    if (fields.size() > 2 || fields[0].empty()) {
+        std::fprintf(stderr, "Invalid prefetch buffer: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    prefetch.buffer = parse_tlb_size(fields[0]);
+    if (fields.size() > 1) {
+        prefetch.cost = parse_cost(fields[1]);
+    }
+}
+
+auto asid_to_string(const AsidConfig& asid) -> std::string {
+    return std::string{asid.mode == AsidMode::Flush ? "flush" : "tagged"} + ":" + std::to_string(asid.flush_cost);
+}
+
+auto parse_asid(const std::string& str, AsidConfig& asid) -> void {
+    auto fields = split_string(str, ":");
+    if (fields.size() > 2) {
+        std::fprintf(stderr, "Invalid ASID mode: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    if (fields[0] == "flush") {
+        asid.mode = AsidMode::Flush;
+    } else if (fields[0] == "tagged") {
+        asid.mode = AsidMode::Tagged;
+    } else {
+        std::fprintf(stderr, "Invalid ASID mode: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    if (fields.size() > 1) {
+        asid.flush_cost = parse_cost(fields[1]);
+    }
+}
+
+auto make_policy(Policy policy, size_type sets, size_type ways, uint64_t seed) -> std::unique_ptr<ReplacementPolicy> {
+    switch (policy) {
+        case Policy::FIFO:
+            return std::make_unique<ReplacementPolicyFifo>(sets, ways, seed);
+
+        case Policy::LRU:
+            return std::make_unique<ReplacementPolicyLru>(sets, ways, seed);
+
+        case Policy::Random:
+            return std::make_unique<ReplacementPolicyRand>(sets, ways, seed);
+
+        case Policy::Clock:
+            return std::make_unique<ReplacementPolicyClock>(sets, ways, seed);
+
+        case Policy::Plru:
+            return std::make_unique<ReplacementPolicyPlru>(sets, ways, seed);
+
+        case Policy::Srrip:
+            return std::make_unique<ReplacementPolicySrrip>(sets, ways, seed);
+
+        case Policy::Brrip:
+            return std::make_unique<ReplacementPolicyBrrip>(sets, ways, seed);
+
+        case Policy::Drrip:
+            return std::make_unique<ReplacementPolicyDrrip>(sets, ways, seed);
+
+        case Policy::Lfu:
+            return std::make_unique<ReplacementPolicyLfu>(sets, ways, seed);
+
+        default:
+            std::abort();
+    }
+}
+
+auto make_tlb(const LevelConfig& level, uint64_t seed, std::unique_ptr<Tlb>&& next) -> std::unique_ptr<Tlb> {
+    switch (level.policy) {
+        case Policy::FIFO:
+            return std::make_unique<TlbImpl<ReplacementPolicyFifo>>(level.cost, level.size, level.ways, seed,
+                                                                    level.shared, std::move(next));
+
+        case Policy::LRU:
+            return std::make_unique<TlbImpl<ReplacementPolicyLru>>(level.cost, level.size, level.ways, seed,
+                                                                   level.shared, std::move(next));
+
+        case Policy::Random:
+            return std::make_unique<TlbImpl<ReplacementPolicyRand>>(level.cost, level.size, level.ways, seed,
+                                                                    level.shared, std::move(next));
+
+        case Policy::Clock:
+            return std::make_unique<TlbImpl<ReplacementPolicyClock>>(level.cost, level.size, level.ways, seed,
+                                                                     level.shared, std::move(next));
+
+        case Policy::Plru:
+            return std::make_unique<TlbImpl<ReplacementPolicyPlru>>(level.cost, level.size, level.ways, seed,
+                                                                    level.shared, std::move(next));
+
+        case Policy::Srrip:
+            return std::make_unique<TlbImpl<ReplacementPolicySrrip>>(level.cost, level.size, level.ways, seed,
+                                                                     level.shared, std::move(next));
+
+        case Policy::Brrip:
+            return std::make_unique<TlbImpl<ReplacementPolicyBrrip>>(level.cost, level.size, level.ways, seed,
+                                                                     level.shared, std::move(next));
+
+        case Policy::Drrip:
+            return std::make_unique<TlbImpl<ReplacementPolicyDrrip>>(level.cost, level.size, level.ways, seed,
+                                                                     level.shared, std::move(next));
+
+        case Policy::Lfu:
+            return std::make_unique<TlbImpl<ReplacementPolicyLfu>>(level.cost, level.size, level.ways, seed,
+                                                                   level.shared, std::move(next));
+
+        default:
+            std::abort();
+    }
+}
+
+// stripes of sets of a shared level locked apart, only sets the level keeps nothing common to can be
+static auto shared_stripes(const LevelConfig& level) -> size_type {
+    // a random or dueling policy keeps state for all sets, wide sets share one index
+    if (level.ways == 0 || level.ways > kMaxScanWays || policy_ties_sets(level.policy)) {
+        return 1;
+    }
+    return std::min<size_type>(level.size / level.ways, 64);
+}
+
+auto make_hierarchy(const std::vector<LevelConfig>& levels, uint64_t seed, bool dynamic, SharedTlbs* shared)
+    -> std::unique_ptr<Tlb> {
+    // a disabled level would only pass everything through
+    std::vector<LevelConfig> enabled{};
+    bool sharing = false;
+    for (const auto& level : levels) {
+        if (level.size != 0) {
+            enabled.push_back(level);
+            sharing = sharing || level.shared;
+        }
+    }
+
+    if (!dynamic && !sharing) {
+        auto chain = make_tlb_chain(enabled, seed);
+        if (chain) {
+            return chain;
+        }
+    }
+
+    std::unique_ptr<Tlb> tlb = std::make_unique<TlbNull>();
+
+    // build from the last level up
+    for (size_t i = enabled.size(); i-- > 0;) {
+        if (enabled[i].shared && shared != nullptr) {
+            // only the last level is shared, nothing follows it
+            if (shared->size() <= i) {
+                shared->resize(i + 1);
+            }
+            if (!(*shared)[i]) {
+                (*shared)[i] = std::make_shared<SharedLevel>(make_tlb(enabled[i], seed + i, std::move(tlb)),
+                                                             shared_stripes(enabled[i]));
+            }
+            tlb = std::make_unique<TlbShared>((*shared)[i]);
+        } else {
+            tlb = make_tlb(enabled[i], seed + i, std::move(tlb));
+        }
+    }
+
+    return tlb;
+}
+
+auto make_mmu(const MmuConfig& config, SharedPageTlbs* shared) -> std::unique_ptr<Mmu> {
+    std::vector<uint32_t> page_sizes{config.page_size};
+    for (const auto& region : config.regions) {
+        if (std::find(page_sizes.begin(), page_sizes.end(), region.page_size) == page_sizes.end()) {
+            page_sizes.push_back(region.page_size);
+        }
+    }
+
+    std::vector<PageClass> classes{};
+    for (auto page_size : page_sizes) {
+        auto levels = config.levels;
+        for (const auto& page_tlb : config.page_tlbs) {
+            if (page_tlb.page_size != page_size) {
+                continue;
+            }
+            if (levels.empty()) {
+                levels.push_back(page_tlb.level);
+            } else {
+                levels[0] = page_tlb.level;
+            }
+        }
+
+        // translations of different page sizes never share a level
+        SharedTlbs* shared_levels = shared != nullptr ? &(*shared)[page_size] : nullptr;
+        classes.push_back(PageClass{page_size, make_hierarchy(levels, config.seed, config.dynamic, shared_levels)});
+    }
+
+    std::unique_ptr<Mmu> mmu = nullptr;
+    if (config.regions.empty()) {
+        mmu = std::make_unique<Mmu>(std::move(classes[0].tlb), config.pagetable_cost, config.page_size);
+    } else {
+        std::vector<PageRegion> regions{};
+        for (const auto& region : config.regions) {
+            auto page_class = std::find(page_sizes.begin(), page_sizes.end(), region.page_size) - page_sizes.begin();
+            regions.push_back(PageRegion{region.start, region.start + (region.length - 1), static_cast<size_type>(page_class)});
+        }
+        mmu = std::make_unique<Mmu>(std::move(classes), std::move(regions), config.pagetable_cost);
+    }
+
+    if (config.memory.frames != 0) {
+        // all of memory is one set of frames
+        for (size_type i = 0; i < mmu->page_classes(); ++i) {
+            mmu->set_memory(i, config.memory, make_policy(config.memory.policy, 1, config.memory.frames, config.seed));
+        }
+    }
+
+    if (config.prefetch.kind != PrefetchKind::None) {
+        mmu->set_prefetcher(config.prefetch);
+    }
+    mmu->set_asid(config.asid);
+
+    if (config.walk.levels != 0) {
+        // the smallest page in use is resolved by the last table
+        auto base_size = *std::min_element(page_sizes.begin(), page_sizes.end());
+        auto base_bits = static_cast<size_type>(std::log2(base_size));
+        mmu->set_walker(std::make_unique<PageWalker>(config.walk, base_bits, config.pagetable_cost));
+    }
+
+    return mmu;
+}
@@ -0,0 +1,133 @@
+// hierarchy.h
+// Construction of TLB hierarchies and MMUs from their configuration
+// Author: Hank Bao
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "def.h"
+#include "mmu.h"
+#include "page_walk.h"
+#include "physical_memory.h"
+#include "policy.h"
+#include "prefetcher.h"
+#include "tlb.h"
+#include "utils.h"
+
+struct SharedLevel;
+
+// one TLB level, ways of 0 means fully associative and size of 0 disables it
+struct LevelConfig {
+    uint32_t size;
+    uint32_t ways;
+    uint32_t cost;
+    Policy policy;
+    bool shared = false;  // one instance behind every hierarchy built with the same SharedTlbs
+};
+
+// the shared levels already built, by level number
+typedef std::vector<std::shared_ptr<SharedLevel>> SharedTlbs;
+// and those of every page size
+typedef std::map<uint32_t, SharedTlbs> SharedPageTlbs;
+
+// virtual addresses mapped with pages of another size than the default
+struct RegionConfig {
+    uint64_t start;
+    uint64_t length;
+    uint32_t page_size;
+};
+
+// the L1 of the TLBs of one page size, in place of the L1 of the levels
+struct PageTlbConfig {
+    uint32_t page_size;
+    LevelConfig level;
+};
+
+struct MmuConfig {
+    uint32_t page_size;
+    uint32_t pagetable_cost;
+    std::vector<LevelConfig> levels;  // L1 first
+    uint64_t seed;
+    bool dynamic = false;  // never use a precompiled TlbChain
+    std::vector<RegionConfig> regions{};
+    std::vector<PageTlbConfig> page_tlbs{};
+    WalkConfig walk{};
+    MemoryConfig memory{};
+    PrefetchConfig prefetch{};
+    AsidConfig asid{};
+};
+
+// SIZE:COST:POLICY, followed by :WAYS for a set-associative level and :shared for a shared one
+auto level_to_string(const LevelConfig& level) -> std::string;
+
+auto parse_level(const std::string& str) -> LevelConfig;
+
+// one level per line in the format of parse_level, '#' starting a comment
+auto parse_hierarchy_file(const std::string& path) -> std::vector<LevelConfig>;
+
+// only the last level may be shared
+auto validate_levels(const std::vector<LevelConfig>& levels) -> void;
+
+// START:LENGTH:PAGESIZE
+auto region_to_string(const RegionConfig& region) -> std::string;
+
+auto parse_region(const std::string& str) -> RegionConfig;
+
+// one region per line in the format of parse_region, '#' starting a comment
+auto parse_pagemap_file(const std::string& path) -> std::vector<RegionConfig>;
+
+// regions must be aligned to their pages, not overlap and not wrap around
+auto validate_regions(const std::vector<RegionConfig>& regions) -> void;
+
+// PAGESIZE:SIZE:COST:POLICY[:WAYS]
+auto page_tlb_to_string(const PageTlbConfig& page_tlb) -> std::string;
+
+auto parse_page_tlb(const std::string& str) -> PageTlbConfig;
+
+// LEVELS:PWCSIZE:CACHELINES, or flat without a radix page table
+auto walk_to_string(const WalkConfig& walk) -> std::string;
+
+// LEVELS[:PWCSIZE[:CACHELINES]] into walk
+auto parse_walk(const std::string& str, WalkConfig& walk) -> void;
+
+// PWCCOST:LINECOST into walk
+auto parse_walk_costs(const std::string& str, WalkConfig& walk) -> void;
+
+// MINOR[:MAJOR] into memory
+auto parse_fault_costs(const std::string& str, MemoryConfig& memory) -> void;
+
+// KIND[:DEGREE]
+auto prefetcher_to_string(const PrefetchConfig& prefetch) -> std::string;
+
+// KIND[:DEGREE] into prefetch, KIND being none, seq, stride or distance
+auto parse_prefetcher(const std::string& str, PrefetchConfig& prefetch) -> void;
+
+// SIZE[:COST] into prefetch
+auto parse_prefetch_buffer(const std::string& str, PrefetchConfig& prefetch) -> void;
+
+// MODE:COST
+auto asid_to_string(const AsidConfig& asid) -> std::string;
+
+// MODE[:COST] into asid, MODE being flush or tagged
+auto parse_asid(const std::string& str, AsidConfig& asid) -> void;
+
+// a policy of the kind for sets * ways slots
+auto make_policy(Policy policy, size_type sets, size_type ways, uint64_t seed) -> std::unique_ptr<ReplacementPolicy>;
+
+// a single level in front of next
+auto make_tlb(const LevelConfig& level, uint64_t seed, std::unique_ptr<Tlb>&& next) -> std::unique_ptr<Tlb>;
+
+// The chain of the enabled levels ending with the null TLB, the i-th of
+// them seeded with seed + i; disabled levels are left out altogether. A
+// precompiled TlbChain is used if one matches the levels, unless dynamic is
+// set. Shared levels are taken from shared, built there on first use, or
+// private if shared is nullptr.
+auto make_hierarchy(const std::vector<LevelConfig>& levels, uint64_t seed, bool dynamic = false,
+                    SharedTlbs* shared = nullptr) -> std::unique_ptr<Tlb>;
+
+// one hierarchy for every page size in use, the default size first
+auto make_mmu(const MmuConfig& config, SharedPageTlbs* shared = nullptr) -> std::unique_ptr<Mmu>;
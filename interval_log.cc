@@ -0,0 +1,113 @@
+// interval_log.cc
+// Statistics of every interval of a run, for phase analysis
+// Author: Hank Bao
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#include "interval_log.h"
+#include "mmu.h"
+#include "utils.h"
+
+IntervalLog::IntervalLog(const std::string& path, LogFormat format, uint64_t length, const Mmu& mmu)
+    : format_{format}, length_{length}, mmu_{mmu}, writer_{path}, current_{0, 0, 0, 0, 0}, last_{}, now_{} {
+    read_levels(last_);
+
+    if (format_ == LogFormat::Csv) {
+        writer_.put_str("interval,accesses,hits,misses,hitrate,mpka,cost,avg_cost");
+        // the levels of the first page class are l1, l2, ..., those of the others prefixed by their page size
+        for (size_type c = 0; c < mmu_.page_classes(); ++c) {
+            auto levels = mmu_.level_stats(c);
+            for (size_t i = 0; i < levels.size(); ++i) {
+                std::string prefix = c == 0 ? "" : "p" + std::to_string(mmu_.page_size(c)) + "_";
+                prefix += "l" + std::to_string(i + 1) + "_";
+                writer_.put_str(("," + prefix + "hits," + prefix + "misses," + prefix + "hitrate").c_str());
+            }
+        }
+        writer_.put_char('\n');
+    }
+}
+
+auto IntervalLog::read_levels(std::vector<LevelStats>& levels) const -> void {
+    levels.clear();
+    for (size_type c = 0; c < mmu_.page_classes(); ++c) {
+        auto stats = mmu_.level_stats(c);
+        levels.insert(levels.end(), stats.begin(), stats.end());
+    }
+}
+
+auto IntervalLog::finish() -> void {
+    if (current_.accesses != 0 || current_.cost != 0) {
+        close_interval();
+    }
+    writer_.flush();
+}
+
+auto IntervalLog::close_interval() -> void {
+    read_levels(now_);
+
+    switch (format_) {
+        case LogFormat::Binary:
+            writer_.write(&current_, sizeof(current_));
+            for (size_t i = 0; i < now_.size(); ++i) {
+                uint64_t level[2] = {now_[i].hits - last_[i].hits, now_[i].misses - last_[i].misses};
+                writer_.write(level, sizeof(level));
+            }
+            break;
+
+        case LogFormat::Csv: {
+            // misses per thousand accesses, the trace carrying no instruction count
+            char ratios[96];
+            const auto& r = current_;
+            std::snprintf(ratios, sizeof(ratios), "%.4f,%.2f,", r.accesses ? r.hits / (double)r.accesses : 0.0,
+                          r.accesses ? 1000.0 * r.misses / r.accesses : 0.0);
+            writer_.put_uint(r.interval);
+            writer_.put_char(',');
+            writer_.put_uint(r.accesses);
+            writer_.put_char(',');
+            writer_.put_uint(r.hits);
+            writer_.put_char(',');
+            writer_.put_uint(r.misses);
+            writer_.put_char(',');
+            writer_.put_str(ratios);
+            writer_.put_uint(r.cost);
+            std::snprintf(ratios, sizeof(ratios), ",%.2f", r.accesses ? r.cost / (double)r.accesses : 0.0);
+            writer_.put_str(ratios);
+
+            for (size_t i = 0; i < now_.size(); ++i) {
+                uint64_t hits = now_[i].hits - last_[i].hits;
+                uint64_t misses = now_[i].misses - last_[i].misses;
+                writer_.put_char(',');
+                writer_.put_uint(hits);
+                writer_.put_char(',');
+                writer_.put_uint(misses);
+                std::snprintf(ratios, sizeof(ratios), ",%.4f", hits + misses ? hits / (double)(hits + misses) : 0.0);
+                writer_.put_str(ratios);
+            }
+            writer_.put_char('\n');
+            break;
+        }
+
+        default:
+            std::abort();
+    }
+
+    std::swap(last_, now_);
+    current_ = IntervalRecord{current_.interval + 1, 0, 0, 0, 0};
+}
+
+auto parse_interval(const std::string& str, uint64_t& length, std::string& path) -> void {
+    auto colon = str.find(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == str.size()) {
+        std::fprintf(stderr, "Invalid interval: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    length = str_to_num(str.substr(0, colon));
+    path = str.substr(colon + 1);
+    if (length == 0) {
+        std::fprintf(stderr, "Invalid interval: %s\n", str.c_str());
+        print_usage(true);
+    }
+}
@@ -0,0 +1,73 @@
+// interval_log.h
+// Statistics of every interval of a run, for phase analysis
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "access_log.h"
+#include "buffered_writer.h"
+#include "def.h"
+#include "level_stats.h"
+
+class Mmu;
+
+// the fixed part of one interval, also the layout of the binary log, where
+// it is followed by the hits and misses of every level, two uint64_t each
+struct IntervalRecord {
+    uint64_t interval;
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t cost;
+};
+
+// Splits a run into intervals of a fixed number of accesses and writes a
+// record at the end of each. Counting an access is a few additions, the
+// levels are only read at the end of an interval; their hits and misses are
+// all zero unless built with TLB_STATS.
+class IntervalLog {
+   public:
+    IntervalLog(const std::string& path, LogFormat format, uint64_t length, const Mmu& mmu);
+    ~IntervalLog() = default;
+
+    auto record(bool hit, time_type cost) -> void {
+        if (hit) {
+            current_.hits += 1;
+        } else {
+            current_.misses += 1;
+        }
+        current_.accesses += 1;
+        current_.cost += cost;
+        if (current_.accesses == length_) {
+            close_interval();
+        }
+    }
+    // a cost of no access, such as a context switch
+    auto charge(time_type cost) -> void { current_.cost += cost; }
+    // write the last interval out, if anything happened in it
+    auto finish() -> void;
+
+   private:
+    auto read_levels(std::vector<LevelStats>& levels) const -> void;
+    auto close_interval() -> void;
+
+   private:
+    const LogFormat format_;
+    const uint64_t length_;
+    const Mmu& mmu_;
+    BufferedWriter writer_;
+    IntervalRecord current_;
+    std::vector<LevelStats> last_;  // the level counters at the start of the interval
+    std::vector<LevelStats> now_;   // scratch of close_interval
+
+   private:
+    IntervalLog(const IntervalLog&) = delete;
+    IntervalLog& operator=(const IntervalLog&) = delete;
+};
+
+// ACCESSES:FILE
+auto parse_interval(const std::string& str, uint64_t& length, std::string& path) -> void;
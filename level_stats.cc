@@ -0,0 +1,103 @@
+// level_stats.cc
+// Counters of the TLB levels and classification of their misses
+// Author: Hank Bao
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+#include "level_stats.h"
+#include "stack_distance.h"
+
+#ifdef TLB_STATS
+
+LevelCounters::LevelCounters(size_type entries, bool shared)
+    : entries_{entries},
+      shared_{shared},
+      hits_{0},
+      misses_{0},
+      insertions_{0},
+      evictions_{0},
+      shadow_{nullptr},
+      compulsory_{0},
+      capacity_{0},
+      conflict_{0} {}
+
+LevelCounters::~LevelCounters() = default;
+
+auto LevelCounters::enable_classification() -> void {
+    // the shadow takes the vpns as they are, the page size does not matter
+    shadow_ = std::make_unique<StackDistance>(1);
+}
+
+auto LevelCounters::classify(page_type vpn, bool hit) -> void {
+    std::unique_lock<std::mutex> guard{shadow_lock_, std::defer_lock};
+    if (shared_) {
+        guard.lock();
+    }
+
+    auto distance = shadow_->reference(vpn, true);
+    if (hit) {
+        return;
+    }
+
+    if (distance == StackDistance::kCold) {
+        compulsory_ += 1;
+    } else if (distance >= entries_) {
+        capacity_ += 1;
+    } else {
+        conflict_ += 1;
+    }
+}
+
+auto LevelCounters::stats() const -> LevelStats {
+    LevelStats stats{entries_, hits_.load(), misses_.load(), insertions_.load(), evictions_.load(), shadow_ != nullptr,
+                     compulsory_, capacity_, conflict_, {}, 0};
+
+    if (shadow_) {
+        stats.cold = shadow_->compulsory();
+        // bucket d holds the distances of bit length d
+        const auto& histogram = shadow_->histogram();
+        for (uint64_t distance = 0; distance < histogram.size(); ++distance) {
+            size_t bucket = 0;
+            while ((distance >> bucket) != 0) {
+                bucket += 1;
+            }
+            if (bucket >= stats.reuse.size()) {
+                stats.reuse.resize(bucket + 1, 0);
+            }
+            stats.reuse[bucket] += histogram[distance];
+        }
+    }
+
+    return stats;
+}
+
+#endif
+
+auto print_level_stats(size_type page_size, const std::vector<LevelStats>& levels) -> void {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const auto& level = levels[i];
+        std::printf("LEVELSTATS pages %u, level %zu, entries %u, hits %" PRIu64 ", misses %" PRIu64 ", insertions %" PRIu64
+                    ", evictions %" PRIu64,
+                    page_size, i + 1, level.entries, level.hits, level.misses, level.insertions, level.evictions);
+        if (level.classified) {
+            std::printf(", compulsory %" PRIu64 ", capacity %" PRIu64 ", conflict %" PRIu64,
+                        level.compulsory, level.capacity, level.conflict);
+        }
+        std::puts("");
+
+        if (level.classified) {
+            std::printf("REUSESTATS pages %u, level %zu", page_size, i + 1);
+            for (size_t bucket = 0; bucket < level.reuse.size(); ++bucket) {
+                if (bucket < 2) {
+                    std::printf(", %zu: %" PRIu64, bucket, level.reuse[bucket]);
+                } else {
+                    std::printf(", %" PRIu64 "-%" PRIu64 ": %" PRIu64, uint64_t{1} << (bucket - 1),
+                                (uint64_t{1} << bucket) - 1, level.reuse[bucket]);
+                }
+            }
+            std::printf(", cold: %" PRIu64 "\n", level.cold);
+        }
+    }
+}
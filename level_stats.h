@@ -0,0 +1,118 @@
+// level_stats.h
+// Counters of the TLB levels and classification of their misses
+// Author: Hank Bao
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "def.h"
+
+class StackDistance;
+
+// whether the levels count, built with -DTLB_STATS
+#ifdef TLB_STATS
+constexpr bool kLevelStats = true;
+#else
+constexpr bool kLevelStats = false;
+#endif
+
+struct LevelStats {
+    size_type entries;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;  // valid entries pushed out, on to the next level if any
+    // the three Cs, only if classified: a miss is compulsory on the first
+    // reference to its page, a capacity miss if a fully associative LRU
+    // level of as many entries would miss too, a conflict miss otherwise
+    bool classified;
+    uint64_t compulsory;
+    uint64_t capacity;
+    uint64_t conflict;
+    // lookups by reuse distance, the pages looked up in between: 0, 1, 2-3, 4-7, ...
+    // and those of pages never looked up before
+    std::vector<uint64_t> reuse;
+    uint64_t cold;
+};
+
+#ifdef TLB_STATS
+
+// What one level counts. The classification runs the lookups of the level
+// through a shadow LRU stack, a tree update per lookup, so it is only done
+// once asked for. A shared level is counted by several cores at once, which
+// only hold the lock of the stripe of the set they touch: its counters are
+// incremented atomically and its shadow has a lock of its own. A private
+// level's are only loaded and stored, as cheap as plain integers.
+class LevelCounters {
+   public:
+    LevelCounters(size_type entries, bool shared);
+    ~LevelCounters();
+
+    auto lookup(page_type vpn, bool hit) -> void {
+        count(hit ? hits_ : misses_);
+        if (shadow_) {
+            classify(vpn, hit);
+        }
+    }
+    auto insert() -> void { count(insertions_); }
+    auto evict() -> void { count(evictions_); }
+
+    auto enable_classification() -> void;
+    auto stats() const -> LevelStats;
+
+   private:
+    auto count(std::atomic<uint64_t>& counter) -> void {
+        if (shared_) {
+            counter.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+    auto classify(page_type vpn, bool hit) -> void;
+
+   private:
+    const size_type entries_;
+    const bool shared_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> insertions_;
+    std::atomic<uint64_t> evictions_;
+    std::mutex shadow_lock_;  // taken by shared levels only
+    std::unique_ptr<StackDistance> shadow_;
+    uint64_t compulsory_;
+    uint64_t capacity_;
+    uint64_t conflict_;
+
+   private:
+    LevelCounters(const LevelCounters&) = delete;
+    LevelCounters& operator=(const LevelCounters&) = delete;
+};
+
+#else
+
+// nothing to count, every call inlined away
+class LevelCounters {
+   public:
+    LevelCounters(size_type entries, bool shared) {}
+
+    auto lookup(page_type vpn, bool hit) -> void {}
+    auto insert() -> void {}
+    auto evict() -> void {}
+
+    auto enable_classification() -> void {}
+    auto stats() const -> LevelStats { return LevelStats{}; }
+
+   private:
+    LevelCounters(const LevelCounters&) = delete;
+    LevelCounters& operator=(const LevelCounters&) = delete;
+};
+
+#endif
+
+// LEVELSTATS, then REUSESTATS if classified, for every level of the pages of page_size
+auto print_level_stats(size_type page_size, const std::vector<LevelStats>& levels) -> void;
@@ -2,48 +2,177 @@
 // Simple tlb implementation for CS5600
 // Author: Hank Bao
 
+#include <algorithm>
+#include <cinttypes>
 #include <memory>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include <getopt.h>
 
+#include "access_log.h"
+#include "block_window.h"
+#include "generator.h"
+#include "hierarchy.h"
+#include "interval_log.h"
 #include "mmu.h"
-#include "policy_fifo.h"
-#include "policy_lru.h"
-#include "policy_rand.h"
-#include "tlb_impl.h"
-#include "tlb_null.h"
+#include "multicore.h"
+#include "sample.h"
+#include "shard.h"
+#include "snapshot.h"
+#include "stack_distance.h"
+#include "sweep.h"
+#include "trace.h"
 #include "utils.h"
 
+// options without a short form
+enum LongOption : int {
+    kOptSets = 0x100,
+    kOptSets2,
+    kOptSeed,
+    kOptSweep,
+    kOptThreads,
+    kOptMrc,
+    kOptDynamic,
+    kOptLevel,
+    kOptHierarchy,
+    kOptRegion,
+    kOptPagemap,
+    kOptPagetlb,
+    kOptWalk,
+    kOptCostwalk,
+    kOptFrames,
+    kOptPagepolicy,
+    kOptCostfault,
+    kOptPrefetcher,
+    kOptPrefetchbuf,
+    kOptAsid,
+    kOptCore,
+    kOptShootdown,
+    kOptShards,
+    kOptSample,
+    kOptGen,
+    kOptGenrounds,
+    kOptLevelstats,
+    kOptInterval,
+    kOptCheckpoint,
+    kOptRestore,
+};
+
+static auto print_final_stats(uint64_t hits, uint64_t misses, uint64_t total_cost) -> void {
+    std::printf("\nFINALSTATS hits %" PRIu64 ", misses %" PRIu64 ", hitrate %.2f, total cost %" PRIu64 "ns, average cost %.2fns\n",
+                hits, misses, hits / (double)(hits + misses), total_cost, total_cost / (double)(hits + misses));
+}
+
+static auto print_context_stats(const ContextStats& cs) -> void {
+    if (cs.switches != 0) {
+        std::printf("CONTEXTSTATS switches %" PRIu64 ", flushes %" PRIu64 ", flush cost %" PRIu64 "ns, reloads %" PRIu64
+                    ", reload cost %" PRIu64 "ns\n",
+                    cs.switches, cs.flushes, cs.flush_cost, cs.reloads, cs.reload_cost);
+    }
+}
+
 auto main(int argc, char** argv) -> int {
     uint32_t page_size = 4096;
     uint32_t tlb_size = 64;
     uint32_t tlb_cost = 5;
+    uint32_t tlb_ways = 0;
+    uint32_t tlb_sets = 0;
     uint32_t tlb_l2_size = 0;
+    uint32_t tlb_l2_ways = 0;
+    uint32_t tlb_l2_sets = 0;
     uint32_t tlb_l2_cost = 20;
     uint32_t pagetable_cost = 100;
     Policy tlb_policy = Policy::FIFO;
     Policy tlb_l2_policy = Policy::LRU;
-    std::vector<uint32_t> access{};
-    std::vector<uint32_t> prefetches{};
+    uint64_t seed = 0;
+    std::vector<addr_type> access{};
+    std::vector<addr_type> prefetches{};
+    std::string trace_path{};
+    TraceFormat trace_format = TraceFormat::Text;
+    bool quiet = false;
+    std::string log_path{};
+    LogFormat log_format = LogFormat::Csv;
+    std::string sweep_grid{};
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool dynamic = false;
+    bool mrc = false;
+    std::string mrc_path{};
+    std::vector<LevelConfig> levels{};
+    std::vector<RegionConfig> regions{};
+    std::vector<PageTlbConfig> page_tlbs{};
+    WalkConfig walk{};
+    MemoryConfig memory{};
+    PrefetchConfig prefetch{};
+    AsidConfig asid{};
+    std::vector<std::string> core_traces{};
+    ShootdownConfig shootdown{};
+    size_t shards = 0;
+    SampleConfig sample{};
+    std::vector<GeneratorConfig> phases{};
+    uint64_t rounds = 1;
+    bool level_stats = false;
+    uint64_t interval = 0;
+    std::string interval_path{};
+    uint64_t checkpoint = 0;
+    std::string checkpoint_path{};
+    std::string restore_path{};
 
     int opt;
     struct option long_options[] = {
         {"size", optional_argument, nullptr, 's'},
         {"tlb", optional_argument, nullptr, 't'},
         {"cost", optional_argument, nullptr, 'c'},
+        {"ways", required_argument, nullptr, 'w'},
+        {"sets", required_argument, nullptr, kOptSets},
         {"tlb2", optional_argument, nullptr, 'l'},
+        {"ways2", required_argument, nullptr, 'W'},
+        {"sets2", required_argument, nullptr, kOptSets2},
         {"cost2", optional_argument, nullptr, 'd'},
         {"costpt", optional_argument, nullptr, 'e'},
         {"policy", optional_argument, nullptr, 'p'},
         {"policy2", optional_argument, nullptr, 'q'},
+        {"seed", required_argument, nullptr, kOptSeed},
         {"access", required_argument, nullptr, 'a'},
         {"prefetch", optional_argument, nullptr, 'f'},
+        {"trace", required_argument, nullptr, 'T'},
+        {"format", required_argument, nullptr, 'F'},
+        {"quiet", no_argument, nullptr, 'Q'},
+        {"log", required_argument, nullptr, 'o'},
+        {"logformat", required_argument, nullptr, 'O'},
+        {"sweep", required_argument, nullptr, kOptSweep},
+        {"threads", required_argument, nullptr, kOptThreads},
+        {"mrc", optional_argument, nullptr, kOptMrc},
+        {"dynamic", no_argument, nullptr, kOptDynamic},
+        {"level", required_argument, nullptr, kOptLevel},
+        {"hierarchy", required_argument, nullptr, kOptHierarchy},
+        {"region", required_argument, nullptr, kOptRegion},
+        {"pagemap", required_argument, nullptr, kOptPagemap},
+        {"pagetlb", required_argument, nullptr, kOptPagetlb},
+        {"walk", required_argument, nullptr, kOptWalk},
+        {"costwalk", required_argument, nullptr, kOptCostwalk},
+        {"frames", required_argument, nullptr, kOptFrames},
+        {"pagepolicy", required_argument, nullptr, kOptPagepolicy},
+        {"costfault", required_argument, nullptr, kOptCostfault},
+        {"prefetcher", required_argument, nullptr, kOptPrefetcher},
+        {"prefetchbuf", required_argument, nullptr, kOptPrefetchbuf},
+        {"asid", required_argument, nullptr, kOptAsid},
+        {"core", required_argument, nullptr, kOptCore},
+        {"shootdown", required_argument, nullptr, kOptShootdown},
+        {"shards", required_argument, nullptr, kOptShards},
+        {"sample", required_argument, nullptr, kOptSample},
+        {"gen", required_argument, nullptr, kOptGen},
+        {"genrounds", required_argument, nullptr, kOptGenrounds},
+        {"levelstats", no_argument, nullptr, kOptLevelstats},
+        {"interval", required_argument, nullptr, kOptInterval},
+        {"checkpoint", required_argument, nullptr, kOptCheckpoint},
+        {"restore", required_argument, nullptr, kOptRestore},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, 0, nullptr, 0}};
 
-    while ((opt = getopt_long(argc, argv, "s:t:c:l:d:e:p:q:a:f:h", long_options, nullptr)) != -1) {
+    while ((opt = getopt_long(argc, argv, "s:t:w:c:l:W:d:e:p:q:a:f:T:F:Qo:O:h", long_options, nullptr)) != -1) {
         switch (opt) {
             case 'h':
                 print_usage(false);
@@ -57,9 +186,21 @@ auto main(int argc, char** argv) -> int {
             case 'c':
                 tlb_cost = parse_cost(optarg);
                 break;
+            case 'w':
+                tlb_ways = parse_ways(optarg);
+                break;
+            case kOptSets:
+                tlb_sets = parse_sets(optarg);
+                break;
             case 'l':
                 tlb_l2_size = parse_tlb_size(optarg);
                 break;
+            case 'W':
+                tlb_l2_ways = parse_ways(optarg);
+                break;
+            case kOptSets2:
+                tlb_l2_sets = parse_sets(optarg);
+                break;
             case 'd':
                 tlb_l2_cost = parse_cost(optarg);
                 break;
@@ -72,11 +213,120 @@ auto main(int argc, char** argv) -> int {
             case 'q':
                 tlb_l2_policy = parse_policy(optarg);
                 break;
+            case kOptSeed:
+                seed = parse_seed(optarg);
+                break;
             case 'a':
                 access = parse_addrs(optarg);
                 break;
             case 'f':
                 prefetches = parse_addrs(optarg);
+                if (std::any_of(prefetches.begin(), prefetches.end(),
+                                [](addr_type addr) { return is_context_switch(addr) || is_unmap(addr); })) {
+                    std::fprintf(stderr, "Invalid prefetch: context switches and unmaps cannot be prefetched\n");
+                    print_usage(true);
+                }
+                break;
+            case 'T':
+                trace_path = optarg;
+                break;
+            case 'F':
+                trace_format = parse_trace_format(optarg);
+                break;
+            case 'Q':
+                quiet = true;
+                break;
+            case 'o':
+                log_path = optarg;
+                break;
+            case 'O':
+                log_format = parse_log_format(optarg);
+                break;
+            case kOptSweep:
+                sweep_grid = optarg;
+                break;
+            case kOptThreads:
+                threads = parse_threads(optarg);
+                break;
+            case kOptDynamic:
+                dynamic = true;
+                break;
+            case kOptMrc:
+                mrc = true;
+                mrc_path = optarg != nullptr ? optarg : "";
+                break;
+            case kOptLevel:
+                levels.push_back(parse_level(optarg));
+                break;
+            case kOptHierarchy: {
+                auto file_levels = parse_hierarchy_file(optarg);
+                levels.insert(levels.end(), file_levels.begin(), file_levels.end());
+                break;
+            }
+            case kOptRegion:
+                regions.push_back(parse_region(optarg));
+                break;
+            case kOptPagemap: {
+                auto file_regions = parse_pagemap_file(optarg);
+                regions.insert(regions.end(), file_regions.begin(), file_regions.end());
+                break;
+            }
+            case kOptPagetlb:
+                page_tlbs.push_back(parse_page_tlb(optarg));
+                break;
+            case kOptWalk:
+                parse_walk(optarg, walk);
+                break;
+            case kOptCostwalk:
+                parse_walk_costs(optarg, walk);
+                break;
+            case kOptFrames:
+                memory.frames = parse_frames(optarg);
+                break;
+            case kOptPagepolicy:
+                memory.policy = parse_policy(optarg);
+                break;
+            case kOptCostfault:
+                parse_fault_costs(optarg, memory);
+                break;
+            case kOptPrefetcher:
+                parse_prefetcher(optarg, prefetch);
+                break;
+            case kOptPrefetchbuf:
+                parse_prefetch_buffer(optarg, prefetch);
+                break;
+            case kOptAsid:
+                parse_asid(optarg, asid);
+                break;
+            case kOptCore:
+                core_traces.push_back(optarg);
+                break;
+            case kOptShootdown:
+                parse_shootdown(optarg, shootdown);
+                break;
+            case kOptShards:
+                shards = parse_threads(optarg);
+                break;
+            case kOptSample:
+                sample = parse_sample(optarg);
+                break;
+            case kOptGen:
+                phases.push_back(parse_generator(optarg));
+                break;
+            case kOptGenrounds:
+                rounds = parse_rounds(optarg);
+                break;
+            case kOptLevelstats:
+                level_stats = true;
+                break;
+            case kOptInterval:
+                parse_interval(optarg, interval, interval_path);
+                break;
+            case kOptCheckpoint:
+                parse_checkpoint(optarg, checkpoint, checkpoint_path);
+                break;
+            case kOptRestore:
+                restore_path = optarg;
                 break;
             default:
                 std::fprintf(stderr, "Unrecognized option: %c\n", optopt);
@@ -85,68 +335,316 @@ auto main(int argc, char** argv) -> int {
         }
     }
 
-    std::printf("page_size: %u\n", page_size);
-    std::printf("tlb_size: %u\n", tlb_size);
-    std::printf("tlb_cost: %u\n", tlb_cost);
-    std::printf("tlb_l2_size: %u\n", tlb_l2_size);
-    std::printf("tlb_l2_cost: %u\n", tlb_l2_cost);
-    std::printf("pagetable_cost: %u\n", pagetable_cost);
-    std::printf("tlb_policy: %s\n", policy_to_string(tlb_policy).c_str());
-    std::printf("tlb_l2_policy: %s\n", policy_to_string(tlb_l2_policy).c_str());
-    std::printf("access: %s\n", addrs_to_string(access).c_str());
-    std::printf("prefetch: %s\n", addrs_to_string(prefetches).c_str());
-    std::puts("");
+    tlb_ways = resolve_ways(tlb_size, tlb_ways, tlb_sets);
+    tlb_l2_ways = resolve_ways(tlb_l2_size, tlb_l2_ways, tlb_l2_sets);
 
-    std::unique_ptr<Tlb> tlb_null = std::make_unique<TlbNull>();
-    std::unique_ptr<Tlb> tlb_l2 = nullptr;
-    std::unique_ptr<Tlb> tlb = nullptr;
+    // explicit levels replace the two set by the TLB options
+    bool custom = !levels.empty();
+    if (!custom) {
+        levels = {
+            LevelConfig{tlb_size, tlb_ways, tlb_cost, tlb_policy},
+            LevelConfig{tlb_l2_size, tlb_l2_ways, tlb_l2_cost, tlb_l2_policy},
+        };
+    }
+    validate_levels(levels);
+    validate_regions(regions);
+    if (!core_traces.empty() && (!access.empty() || !trace_path.empty() || !log_path.empty() || !sweep_grid.empty() || mrc)) {
+        std::fprintf(stderr, "Cores replay their own traces, --core excludes -a, -T, -o, --sweep and --mrc\n");
+        print_usage(true);
+    }
+    if (!phases.empty() && (!access.empty() || !trace_path.empty() || !core_traces.empty())) {
+        std::fprintf(stderr, "--gen generates the references, it excludes -a, -T and --core\n");
+        print_usage(true);
+    }
+    if (shards != 0 && (!core_traces.empty() || !log_path.empty() || !sweep_grid.empty() || mrc)) {
+        std::fprintf(stderr, "--shards splits a single MMU, it excludes --core, -o, --sweep and --mrc\n");
+        print_usage(true);
+    }
+    if (sample.kind != SampleKind::None &&
+        (shards != 0 || !core_traces.empty() || !log_path.empty() || !sweep_grid.empty() || mrc)) {
+        std::fprintf(stderr, "--sample runs a single MMU, it excludes --shards, --core, -o, --sweep and --mrc\n");
+        print_usage(true);
+    }
 
-    switch (tlb_l2_policy) {
-        case Policy::FIFO:
-            tlb_l2 = std::make_unique<TlbImpl<ReplacementPolicyFifo>>(tlb_l2_cost, tlb_l2_size, std::move(tlb_null));
-            break;
+    if (level_stats && !kLevelStats) {
+        std::fprintf(stderr, "--levelstats needs the level counters, built without TLB_STATS\n");
+        print_usage(true);
+    }
+    if ((level_stats || interval != 0) && (shards != 0 || sample.kind != SampleKind::None || !core_traces.empty() ||
+                                           !sweep_grid.empty() || mrc)) {
+        std::fprintf(stderr, "--levelstats and --interval report a single MMU, they exclude --shards, --sample, --core,"
+                             " --sweep and --mrc\n");
+        print_usage(true);
+    }
+    // the frames and the prefetchers are not part of a snapshot
+    bool snapshots = !checkpoint_path.empty() || !restore_path.empty();
+    if (snapshots && (memory.frames != 0 || prefetch.kind != PrefetchKind::None || shards != 0 ||
+                      sample.kind != SampleKind::None || !core_traces.empty() || mrc)) {
+        std::fprintf(stderr, "--checkpoint and --restore keep the TLBs of one MMU, they exclude --frames, --prefetcher,"
+                             " --shards, --sample, --core and --mrc\n");
+        print_usage(true);
+    }
+    if (!checkpoint_path.empty() && !sweep_grid.empty()) {
+        std::fprintf(stderr, "--checkpoint saves a single MMU, it excludes --sweep\n");
+        print_usage(true);
+    }
 
-        case Policy::LRU:
-            tlb_l2 = std::make_unique<TlbImpl<ReplacementPolicyLru>>(tlb_l2_cost, tlb_l2_size, std::move(tlb_null));
-            break;
+    MmuConfig config{page_size, pagetable_cost, levels, seed, dynamic, regions, page_tlbs, walk, memory, prefetch, asid};
 
-        case Policy::Random:
-            tlb_l2 = std::make_unique<TlbImpl<ReplacementPolicyRand>>(tlb_l2_cost, tlb_l2_size, std::move(tlb_null));
-            break;
+    // the references, from the generators, the trace or the access list, read in blocks
+    std::unique_ptr<Workload> workload = nullptr;
+    std::unique_ptr<TraceReader> reader = nullptr;
+    size_t access_pos = 0;
+    SweepSource source = [&](addr_type* addrs, size_t max) -> size_t {
+        if (workload) {
+            return workload->read(addrs, max);
+        } else if (reader) {
+            return reader->read(addrs, max);
+        }
+        size_t n = std::min(max, access.size() - access_pos);
+        std::copy_n(access.begin() + access_pos, n, addrs);
+        access_pos += n;
+        return n;
+    };
+    auto open_source = [&] {
+        if (!phases.empty()) {
+            workload = std::make_unique<Workload>(phases, rounds, page_size, seed);
+        } else if (!trace_path.empty()) {
+            reader = std::make_unique<TraceReader>(trace_path, trace_format);
+        }
+    };
 
-        default:
-            std::abort();
+    // a restored run goes on from the reference after those the snapshot has seen
+    std::unique_ptr<Snapshot> snapshot = nullptr;
+    if (!restore_path.empty()) {
+        snapshot = std::make_unique<Snapshot>(restore_path);
+        if (!checkpoint_path.empty() && checkpoint < snapshot->position()) {
+            std::fprintf(stderr, "Checkpoint %" PRIu64 " comes before the snapshot, taken at %" PRIu64 "\n",
+                         checkpoint, snapshot->position());
+            print_usage(true);
+        }
     }
+    auto skip_source = [&] {
+        std::vector<addr_type> block(kBlockSize);
+        for (uint64_t left = snapshot->position(); left != 0;) {
+            size_t n = source(block.data(), static_cast<size_t>(std::min<uint64_t>(left, block.size())));
+            if (n == 0) {
+                std::fprintf(stderr, "The references end before the snapshot, taken at %" PRIu64 "\n",
+                             snapshot->position());
+                ::exit(EXIT_FAILURE);
+            }
+            left -= n;
+        }
+    };
 
-    switch (tlb_policy) {
-        case Policy::FIFO:
-            tlb = std::make_unique<TlbImpl<ReplacementPolicyFifo>>(tlb_cost, tlb_size, std::move(tlb_l2));
-            break;
+    if (!sweep_grid.empty()) {
+        auto configs = expand_sweep_grid(config, sweep_grid);
 
-        case Policy::LRU:
-            tlb = std::make_unique<TlbImpl<ReplacementPolicyLru>>(tlb_cost, tlb_size, std::move(tlb_l2));
-            break;
+        open_source();
+        if (snapshot) {
+            skip_source();
+        }
+        auto results = run_sweep(configs, threads, prefetches, source, snapshot.get());
 
-        case Policy::Random:
-            tlb = std::make_unique<TlbImpl<ReplacementPolicyRand>>(tlb_cost, tlb_size, std::move(tlb_l2));
-            break;
+        print_sweep_table(configs, results);
+        return EXIT_SUCCESS;
+    }
 
-        default:
-            std::abort();
+    if (mrc) {
+        // every fully associative LRU size at once, the TLB options other than the costs are moot
+        StackDistance sd{page_size};
+        for (const auto& addr : prefetches) {
+            sd.access(addr, true);
+        }
+
+        open_source();
+        std::vector<addr_type> block(kBlockSize);
+        while (size_t n = source(block.data(), block.size())) {
+            for (size_t i = 0; i < n; ++i) {
+                const auto addr = block[i];
+                if (is_context_switch(addr)) {
+                    sd.switch_context(switch_asid(addr));
+                } else if (!is_unmap(addr)) {
+                    sd.access(addr, false);
+                }
+            }
+        }
+
+        if (mrc_path.empty()) {
+            print_miss_ratio_curve(sd, tlb_cost, pagetable_cost);
+        } else {
+            write_miss_ratio_curve(sd, mrc_path);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (!quiet) {
+        std::printf("page_size: %u\n", page_size);
+        if (custom) {
+            for (size_t i = 0; i < levels.size(); ++i) {
+                std::printf("tlb_level%zu: %s\n", i + 1, level_to_string(levels[i]).c_str());
+            }
+            std::printf("pagetable_cost: %u\n", pagetable_cost);
+        } else {
+            std::printf("tlb_size: %u\n", tlb_size);
+            std::printf("tlb_ways: %s\n", ways_to_string(tlb_size, tlb_ways).c_str());
+            std::printf("tlb_cost: %u\n", tlb_cost);
+            std::printf("tlb_l2_size: %u\n", tlb_l2_size);
+            std::printf("tlb_l2_ways: %s\n", ways_to_string(tlb_l2_size, tlb_l2_ways).c_str());
+            std::printf("tlb_l2_cost: %u\n", tlb_l2_cost);
+            std::printf("pagetable_cost: %u\n", pagetable_cost);
+            std::printf("tlb_policy: %s\n", policy_to_string(tlb_policy).c_str());
+            std::printf("tlb_l2_policy: %s\n", policy_to_string(tlb_l2_policy).c_str());
+        }
+        for (const auto& region : regions) {
+            std::printf("region: %s\n", region_to_string(region).c_str());
+        }
+        for (const auto& page_tlb : page_tlbs) {
+            std::printf("pagetlb: %s\n", page_tlb_to_string(page_tlb).c_str());
+        }
+        if (walk.levels != 0) {
+            std::printf("walk: %s\n", walk_to_string(walk).c_str());
+            std::printf("walk_costs: %u:%u\n", walk.pwc_cost, walk.cache_cost);
+        }
+        if (memory.frames != 0) {
+            std::printf("frames: %u\n", memory.frames);
+            std::printf("page_policy: %s\n", policy_to_string(memory.policy).c_str());
+            std::printf("fault_costs: %u:%u\n", memory.minor_cost, memory.major_cost);
+        }
+        if (prefetch.kind != PrefetchKind::None) {
+            std::printf("prefetcher: %s\n", prefetcher_to_string(prefetch).c_str());
+            std::printf("prefetch_buffer: %u:%u\n", prefetch.buffer, prefetch.cost);
+        }
+        std::printf("asid: %s\n", asid_to_string(asid).c_str());
+        std::printf("seed: %" PRIu64 "\n", seed);
+        if (!core_traces.empty()) {
+            for (size_t c = 0; c < core_traces.size(); ++c) {
+                std::printf("core%zu: %s\n", c, core_traces[c].c_str());
+            }
+            std::printf("shootdown: %u:%u\n", shootdown.ipi_cost, shootdown.handler_cost);
+        } else if (!phases.empty()) {
+            for (const auto& gen : phases) {
+                std::printf("gen: %s\n", generator_to_string(gen).c_str());
+            }
+            std::printf("gen_rounds: %" PRIu64 "\n", rounds);
+        } else if (trace_path.empty()) {
+            std::printf("access: %s\n", addrs_to_string(access).c_str());
+        } else {
+            std::printf("trace: %s\n", trace_path.c_str());
+        }
+        std::printf("prefetch: %s\n", addrs_to_string(prefetches).c_str());
+        if (shards != 0) {
+            std::printf("shards: %zu\n", shards);
+        }
+        if (sample.kind != SampleKind::None) {
+            std::printf("sample: %s\n", sample_to_string(sample).c_str());
+        }
+        if (snapshot) {
+            std::printf("restore: %s at %" PRIu64 "\n", restore_path.c_str(), snapshot->position());
+        }
+        if (!checkpoint_path.empty()) {
+            std::printf("checkpoint: %s at %" PRIu64 "\n", checkpoint_path.c_str(), checkpoint);
+        }
+        std::puts("");
+    }
+
+    if (shards != 0) {
+        validate_shards(config, shards);
+
+        open_source();
+        auto result = run_shards(config, shards, threads, prefetches, source);
+
+        print_final_stats(result.hits, result.misses, result.total_cost);
+        print_context_stats(result.context);
+        return EXIT_SUCCESS;
+    }
+
+    if (sample.kind != SampleKind::None) {
+        validate_sample(config, sample);
+
+        open_source();
+        auto result = run_sample(config, sample, prefetches, source);
+
+        // the measured accesses only, the estimates for the whole stream follow
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t total_cost = 0;
+        for (const auto& unit : result.units) {
+            hits += unit.hits;
+            misses += unit.accesses - unit.hits;
+            total_cost += unit.cost;
+        }
+        print_final_stats(hits, misses, total_cost);
+        print_sample_stats(result);
+        return EXIT_SUCCESS;
+    }
+
+    if (!core_traces.empty()) {
+        auto results = run_cores(config, shootdown, core_traces, trace_format, prefetches);
+
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t total_cost = 0;
+        for (const auto& result : results) {
+            hits += result.hits;
+            misses += result.misses;
+            total_cost += result.total_cost;
+        }
+
+        print_final_stats(hits, misses, total_cost);
+        for (size_t c = 0; c < results.size(); ++c) {
+            const auto& r = results[c];
+            std::printf("CORESTATS core %zu, hits %" PRIu64 ", misses %" PRIu64 ", total cost %" PRIu64
+                        "ns, shootdowns sent %" PRIu64 ", received %" PRIu64 ", shootdown cost %" PRIu64 "ns\n",
+                        c, r.hits, r.misses, r.total_cost, r.shootdowns_sent, r.shootdowns_received, r.shootdown_cost);
+        }
+        return EXIT_SUCCESS;
     }
 
-    auto mmu = std::make_unique<Mmu>(std::move(tlb), pagetable_cost, page_size);
-    if (!prefetches.empty()) {
+    std::unique_ptr<AccessLog> log = nullptr;
+    if (!log_path.empty()) {
+        log = std::make_unique<AccessLog>(log_path, log_format);
+    }
+
+    auto mmu = make_mmu(config);
+    mmu->set_verbose(!quiet);
+    mmu->set_log(log.get());
+    if (level_stats) {
+        mmu->classify_misses();
+    }
+    if (snapshot) {
+        // the prefetches ran before the snapshot was taken, they are part of it
+        snapshot->restore(*mmu);
+    } else {
         for (const auto& addr : prefetches) {
             mmu->access(addr, true);
         }
     }
 
-    uint32_t hits = 0;
-    uint32_t misses = 0;
-    uint32_t total_cost = 0;
+    // from after the prefetches, so the levels count the accesses only
+    std::unique_ptr<IntervalLog> intervals = nullptr;
+    if (interval != 0) {
+        intervals = std::make_unique<IntervalLog>(interval_path, log_format, interval, *mmu);
+    }
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t total_cost = 0;
+
+    auto run = [&](addr_type addr) {
+        if (is_context_switch(addr)) {
+            auto cost = mmu->switch_context(switch_asid(addr));
+            total_cost += cost;
+            if (intervals) {
+                intervals->charge(cost);
+            }
+            return;
+        } else if (is_unmap(addr)) {
+            // a single core has nobody to shoot the page down on
+            mmu->invalidate(unmap_address(addr), mmu->asid());
+            return;
+        }
 
-    for (const auto& addr : access) {
         auto result = mmu->access(addr, false);
         if (result.first) {
             hits += 1;
@@ -154,10 +652,79 @@ auto main(int argc, char** argv) -> int {
             misses += 1;
         }
         total_cost += result.second;
+        if (intervals) {
+            intervals->record(result.first, result.second);
+        }
+    };
+
+    // stream the references into the MMU a block at a time, never held whole
+    open_source();
+    uint64_t position = 0;
+    if (snapshot) {
+        skip_source();
+        position = snapshot->position();
+    }
+    std::vector<addr_type> block(kBlockSize);
+    while (size_t n = source(block.data(), block.size())) {
+        // the block is split at the checkpoint, the loop over the references stays as it is
+        size_t split = n;
+        if (!checkpoint_path.empty() && checkpoint - position < n) {
+            split = static_cast<size_t>(checkpoint - position);
+        }
+        for (size_t i = 0; i < split; ++i) {
+            run(block[i]);
+        }
+        if (split != n) {
+            save_snapshot(checkpoint_path, *mmu, checkpoint);
+            checkpoint_path.clear();
+            for (size_t i = split; i < n; ++i) {
+                run(block[i]);
+            }
+        }
+        position += n;
+    }
+    if (!checkpoint_path.empty()) {
+        if (position < checkpoint) {
+            std::fprintf(stderr, "The references end before the checkpoint, saved at %" PRIu64 " instead\n", position);
+        }
+        save_snapshot(checkpoint_path, *mmu, position);
     }
 
-    std::printf("\nFINALSTATS hits %d, misses %d, hitrate %.2f, total cost %uns, average cost %.2fns\n",
-                hits, misses, hits / (float)(hits + misses), total_cost, total_cost / (float)(hits + misses));
+    uint64_t faults = mmu->faults();
+    uint64_t major_faults = mmu->major_faults();
+    PrefetchStats prefetch_stats = mmu->prefetch_stats();
+    ContextStats context_stats = mmu->context_stats();
+    if (intervals) {
+        intervals->finish();
+        intervals.reset();
+    }
+    std::vector<std::pair<size_type, std::vector<LevelStats>>> levels_stats{};
+    if (level_stats) {
+        for (size_type c = 0; c < mmu->page_classes(); ++c) {
+            levels_stats.emplace_back(mmu->page_size(c), mmu->level_stats(c));
+        }
+    }
+    mmu.reset();
+    log.reset();
+
+    print_final_stats(hits, misses, total_cost);
+    if (memory.frames != 0) {
+        std::printf("PAGESTATS faults %" PRIu64 ", major faults %" PRIu64 ", fault rate %.4f\n",
+                    faults, major_faults, faults / (double)(hits + misses));
+    }
+    if (prefetch.kind != PrefetchKind::None) {
+        // coverage: of the misses the TLBs would have had without prefetching, those the buffer caught
+        const auto& ps = prefetch_stats;
+        std::printf("PREFETCHSTATS issued %" PRIu64 ", useful %" PRIu64 ", late %" PRIu64 ", unused %" PRIu64
+                    ", accuracy %.4f, coverage %.4f, timeliness %.4f\n",
+                    ps.issued, ps.useful, ps.late, ps.unused, ps.issued ? ps.useful / (double)ps.issued : 0.0,
+                    ps.useful + misses ? ps.useful / (double)(ps.useful + misses) : 0.0,
+                    ps.useful ? (ps.useful - ps.late) / (double)ps.useful : 0.0);
+    }
+    print_context_stats(context_stats);
+    for (const auto& [size, stats] : levels_stats) {
+        print_level_stats(size, stats);
+    }
 
     return EXIT_SUCCESS;
 }
@@ -2,56 +2,329 @@
 // MMU simulator implementation
 // Author: Hank Bao
 
+#include <algorithm>
+#include <cinttypes>
 #include <cstdio>
+#include <iterator>
 
 #include "mmu.h"
+#include "page_walk.h"
+#include "physical_memory.h"
+#include "snapshot.h"
+
+// frames below 0x2000 pages of the smallest size are never handed out
+static constexpr page_type kFrameBase = 0x2000;
+
+Mmu::Mmu(std::unique_ptr<Tlb>&& tlb, time_type pagetable_cost, size_type page_size)
+    : Mmu{std::vector<PageClass>{}, std::vector<PageRegion>{}, pagetable_cost} {
+    pages_.push_back(Pages{std::move(tlb), page_size - 1, static_cast<size_type>(std::log2(page_size)), kFrameBase, 0, nullptr, nullptr, nullptr});
+}
+
+Mmu::Mmu(std::vector<PageClass>&& classes, std::vector<PageRegion>&& regions, time_type pagetable_cost)
+    : pages_{},
+      regions_{std::move(regions)},
+      pagetable_cost_{pagetable_cost},
+      walker_{nullptr},
+      faults_{0},
+      major_faults_{0},
+      buffer_cost_{0},
+      prefetch_stats_{},
+      predicted_{},
+      clock_{0},
+      asid_config_{},
+      asid_{0},
+      context_stats_{},
+      flushing_{},
+      flushed_{},
+      verbose_{true},
+      log_{nullptr} {
+    size_type min_bits = 0;
+    for (size_t i = 0; i < classes.size(); ++i) {
+        auto bits = static_cast<size_type>(std::log2(classes[i].page_size));
+        min_bits = i == 0 ? bits : std::min(min_bits, bits);
+    }
+
+    // the same physical base for every class, rounded up to a whole page
+    for (auto& c : classes) {
+        auto bits = static_cast<size_type>(std::log2(c.page_size));
+        auto shift = bits - min_bits;
+        page_type frame_base = (kFrameBase + (page_type{1} << shift) - 1) >> shift;
+        // every table of a radix page table resolves 9 more bits
+        pages_.push_back(Pages{std::move(c.tlb), c.page_size - 1, bits, frame_base, shift / 9, nullptr, nullptr, nullptr});
+    }
+
+    std::sort(regions_.begin(), regions_.end(),
+              [](const PageRegion& a, const PageRegion& b) { return a.start < b.start; });
+}
+
+Mmu::~Mmu() = default;
+
+auto Mmu::set_walker(std::unique_ptr<PageWalker>&& walker) -> void {
+    walker_ = std::move(walker);
+}
+
+auto Mmu::set_memory(size_type page_class, const MemoryConfig& config, std::unique_ptr<ReplacementPolicy>&& policy) -> void {
+    auto& pages = pages_[page_class];
+    pages.memory = std::make_unique<PhysicalMemory>(config, pages.frame_base, std::move(policy));
+}
+
+auto Mmu::set_prefetcher(const PrefetchConfig& config) -> void {
+    buffer_cost_ = config.cost;
+    for (auto& pages : pages_) {
+        pages.prefetcher = make_prefetcher(config);
+        pages.buffer = pages.prefetcher ? std::make_unique<PrefetchBuffer>(config.buffer) : nullptr;
+    }
+}
+
+auto Mmu::level_stats(size_type page_class) const -> std::vector<LevelStats> {
+    std::vector<LevelStats> stats{};
+    pages_[page_class].tlb->level_stats(stats);
+    return stats;
+}
+
+auto Mmu::classify_misses() -> void {
+    for (auto& pages : pages_) {
+        pages.tlb->classify_misses();
+    }
+}
+
+auto Mmu::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint64_t>(pages_.size());
+    for (const auto& pages : pages_) {
+        writer.put(pages.offset_bits);
+        pages.tlb->save(writer);
+    }
+
+    writer.put<uint8_t>(walker_ != nullptr);
+    if (walker_) {
+        walker_->save(writer);
+    }
+
+    writer.put(asid_);
+    writer.put(clock_);
+    writer.put_vector(std::vector<page_type>{flushed_.begin(), flushed_.end()});
+}
+
+auto Mmu::load(SnapshotReader& reader) -> void {
+    reader.expect<uint64_t>(pages_.size(), "page classes");
+    for (auto& pages : pages_) {
+        reader.expect(pages.offset_bits, "page size");
+        pages.tlb->load(reader);
+    }
+
+    reader.expect<uint8_t>(walker_ != nullptr, "page walk");
+    if (walker_) {
+        walker_->load(reader);
+    }
+
+    asid_ = reader.get<asid_type>();
+    clock_ = reader.get<uint64_t>();
+    std::vector<page_type> flushed(reader.get<uint64_t>());
+    for (auto& vpn : flushed) {
+        vpn = reader.get<page_type>();
+    }
+    flushed_ = std::unordered_set<page_type>{flushed.begin(), flushed.end()};
+}
 
 auto Mmu::access(addr_type vaddr, bool prefetching) -> std::pair<bool, time_type> {
-    auto vpn = get_vpn(vaddr);
-    auto offset = get_offset(vaddr);
+    auto& pages = pages_of(vaddr);
+    auto vpn = page_number(vaddr, pages.offset_bits);
+    auto offset = vaddr & pages.offset_mask;
+    // what the TLBs cache, the vpn tagged with the address space
+    auto key = tag_page(vpn, asid_);
 
-    auto attempt = access_tlb(vpn);
-    auto result = attempt.value_or(access_pagetable(vpn));
+    bool hit = true;
+    std::pair<page_type, time_type> result;
+    if (auto attempt = access_tlb(pages, key)) {
+        result = *attempt;
+    } else {
+        // a prefetched translation still saves the walk
+        auto buffered = prefetching ? std::nullopt : access_buffer(pages, key);
+        hit = buffered.has_value();
+        result = hit ? *buffered : access_pagetable(pages, vaddr, key);
+        pages.tlb->insert(key, result.first, true);
+
+        if (!flushed_.empty() && flushed_.erase(key) != 0) {
+            context_stats_.reloads += 1;
+            context_stats_.reload_cost += result.second;
+        }
+
+        if (pages.prefetcher && !prefetching) {
+            prefetch(pages, key);
+        }
+    }
 
     auto pfn = result.first;
     auto cost = result.second;
-    auto paddr = (pfn << offset_mask_) | offset;
+    auto paddr = (pfn << pages.offset_bits) | offset;
+    clock_ += cost;
 
-    bool hit = true;
-    if (!attempt.has_value()) {
-        hit = false;
-        tlb_->insert(vpn, pfn, true);
+    if (verbose_) {
+        if (!prefetching) {
+            std::printf("MMU access: %s, VADDR=0x%08" PRIx64 ", VPN=%" PRIu64 ", OFFSET=0x%08" PRIx64 ", PFN=%" PRIu64
+                        ", PADDR=0x%08" PRIx64 " COST=%uns\n",
+                        hit ? "HIT" : "MISS", vaddr, vpn, offset, pfn, paddr, cost);
+        } else {
+            std::printf("TLB prefetch: %s, VADDR=0x%08" PRIx64 ", VPN=%" PRIu64 ", PFN=%" PRIu64 "\n",
+                        hit ? "HIT" : "MISS", vaddr, vpn, pfn);
+        }
     }
 
-    if (!prefetching) {
-        std::printf("MMU access: %s, VADDR=0x%08x, VPN=%u, OFFSET=0x%08x, PFN=%u, PADDR=0x%08x COST=%uns\n",
-                    hit ? "HIT" : "MISS", vaddr, vpn, offset, pfn, paddr, cost);
-    } else {
-        std::printf("TLB prefetch: %s, VADDR=0x%08x, VPN=%u, PFN=%u\n",
-                    hit ? "HIT" : "MISS", vaddr, vpn, pfn);
+    if (log_ != nullptr) {
+        log_->append(AccessRecord{vaddr, vpn, pfn, paddr, cost, hit, prefetching, 0});
     }
 
     return std::make_pair(hit, cost);
 }
 
-auto Mmu::access_tlb(size_type vpn) -> std::optional<std::pair<addr_type, time_type>> {
-    return tlb_->lookup(vpn);
+auto Mmu::switch_context(asid_type asid) -> time_type {
+    if (asid == asid_) {
+        return 0;
+    }
+
+    asid_ = asid;
+    context_stats_.switches += 1;
+
+    time_type cost = 0;
+    if (asid_config_.mode == AsidMode::Flush) {
+        // untagged translations of the previous address space would be wrong in this one
+        flushing_.clear();
+        for (auto& pages : pages_) {
+            pages.tlb->flush(flushing_);
+            if (pages.buffer) {
+                pages.buffer->flush();
+            }
+        }
+        if (walker_) {
+            walker_->flush();
+        }
+        flushed_.insert(flushing_.begin(), flushing_.end());
+
+        cost = asid_config_.flush_cost;
+        context_stats_.flushes += 1;
+        context_stats_.flush_cost += cost;
+    }
+    clock_ += cost;
+
+    if (verbose_) {
+        std::printf("Context switch: ASID=%u, %s, COST=%uns\n", asid,
+                    asid_config_.mode == AsidMode::Flush ? "FLUSH" : "TAGGED", cost);
+    }
+
+    return cost;
+}
+
+auto Mmu::invalidate(addr_type vaddr, asid_type asid) -> void {
+    auto& pages = pages_of(vaddr);
+    auto vpn = page_number(vaddr, pages.offset_bits);
+    auto key = tag_page(vpn, asid);
+
+    pages.tlb->invalidate(key);
+    if (pages.buffer) {
+        pages.buffer->invalidate(key);
+    }
+
+    if (verbose_) {
+        std::printf("TLB invalidate: VADDR=0x%08" PRIx64 ", VPN=%" PRIu64 ", ASID=%u\n", vaddr, vpn, asid);
+    }
+}
+
+auto Mmu::pages_of(addr_type vaddr) -> Pages& {
+    if (regions_.empty()) {
+        return pages_[0];
+    }
+
+    // the last region starting at or below vaddr
+    auto it = std::upper_bound(regions_.begin(), regions_.end(), vaddr,
+                               [](addr_type addr, const PageRegion& r) { return addr < r.start; });
+    if (it != regions_.begin() && vaddr <= std::prev(it)->last) {
+        return pages_[std::prev(it)->page_class];
+    }
+    return pages_[0];
 }
 
-auto Mmu::access_pagetable(size_type vpn) -> std::pair<addr_type, time_type> {
-    auto pfn = fake_pagetable_map(vpn);
-    return std::make_pair(pfn, pagetable_cost_);
+auto Mmu::access_tlb(Pages& pages, page_type vpn) -> std::optional<std::pair<page_type, time_type>> {
+    return pages.tlb->lookup(vpn);
 }
 
-auto Mmu::get_vpn(addr_type vaddr) -> size_type {
-    return (vaddr & ~offset_mask_) >> offset_bits_;
+auto Mmu::access_pagetable(Pages& pages, addr_type vaddr, page_type vpn) -> std::pair<page_type, time_type> {
+    auto cost = walker_ ? walker_->walk(vaddr, pages.leaf_table, asid_) : pagetable_cost_;
+    if (!pages.memory) {
+        return std::make_pair(fake_pagetable_map(pages, vpn), cost);
+    }
+
+    auto [pfn, fault] = pages.memory->translate(vpn);
+    if (fault) {
+        faults_ += 1;
+        major_faults_ += fault->major;
+        cost += fault->cost;
+
+        if (fault->evicted) {
+            // shoot down the stale translation of the page swapped out
+            pages.tlb->invalidate(*fault->evicted);
+            if (pages.buffer) {
+                pages.buffer->invalidate(*fault->evicted);
+            }
+        }
+
+        if (verbose_) {
+            std::printf("Page fault: %s, VPN=%" PRIu64 ", PFN=%" PRIu64, fault->major ? "MAJOR" : "MINOR",
+                        untag_page(vpn), pfn);
+            if (fault->evicted) {
+                std::printf(", EVICTED VPN=%" PRIu64, untag_page(*fault->evicted));
+            }
+            std::printf(", COST=%uns\n", fault->cost);
+        }
+    }
+
+    return std::make_pair(pfn, cost);
 }
 
-auto Mmu::get_offset(addr_type vaddr) -> size_type {
-    return vaddr & offset_mask_;
+auto Mmu::access_buffer(Pages& pages, page_type vpn) -> std::optional<std::pair<page_type, time_type>> {
+    auto entry = pages.buffer ? pages.buffer->take(vpn) : std::nullopt;
+    if (!entry) {
+        return std::nullopt;
+    }
+
+    // a prefetch still walking makes the miss wait for the rest of its walk
+    prefetch_stats_.useful += 1;
+    time_type cost = buffer_cost_;
+    if (entry->ready > clock_) {
+        prefetch_stats_.late += 1;
+        cost += static_cast<time_type>(entry->ready - clock_);
+    }
+
+    return std::make_pair(entry->pfn, cost);
+}
+
+auto Mmu::prefetch(Pages& pages, page_type vpn) -> void {
+    predicted_.clear();
+    pages.prefetcher->predict(vpn, predicted_);
+
+    for (auto target : predicted_) {
+        if (pages.tlb->probe(target) || pages.buffer->contains(target)) {
+            continue;
+        }
+
+        // prefetches never fault, a page that is not resident is left alone
+        auto pfn = pages.memory ? pages.memory->resident(target) : fake_pagetable_map(pages, target);
+        if (!pfn) {
+            continue;
+        }
+
+        // the walk of a prefetch is off the critical path, only its latency is modelled: priced like a
+        // demand walk through the caches as they are, but leaving them untouched so prefetches do not
+        // change what demand walks cost
+        const addr_type vaddr = untag_page(target) << pages.offset_bits;
+        const auto latency = walker_ ? walker_->estimate(vaddr, pages.leaf_table, asid_) : pagetable_cost_;
+        prefetch_stats_.issued += 1;
+        if (pages.buffer->insert(target, *pfn, clock_ + latency)) {
+            prefetch_stats_.unused += 1;
+        }
+    }
 }
 
-// map a virtual page number to a physical frame number
-auto Mmu::fake_pagetable_map(size_type vpn) -> size_type {
-    return vpn + 0x2000;
+// map a virtual page number to a physical frame number of the same size
+auto Mmu::fake_pagetable_map(Pages& pages, page_type vpn) -> page_type {
+    return untag_page(vpn) + pages.frame_base;
 }
@@ -7,35 +7,147 @@
 #include <cmath>
 #include <memory>
 #include <optional>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
+#include "access_log.h"
 #include "def.h"
+#include "level_stats.h"
+#include "prefetcher.h"
 #include "tlb.h"
 
+class PageWalker;
+class PhysicalMemory;
+class ReplacementPolicy;
+class SnapshotReader;
+class SnapshotWriter;
+struct MemoryConfig;
+
+// page number of a virtual address with pages of 2^offset_bits bytes
+inline auto page_number(addr_type vaddr, size_type offset_bits) -> page_type {
+    return vaddr >> offset_bits;
+}
+
+// one page size and the TLBs caching its translations
+struct PageClass {
+    size_type page_size;
+    std::unique_ptr<Tlb> tlb;
+};
+
+// virtual addresses [start, last] mapped with the pages of one class
+struct PageRegion {
+    addr_type start;
+    addr_type last;
+    size_type page_class;
+};
+
+enum class AsidMode {
+    Flush,   // a switch drops every cached translation
+    Tagged,  // translations carry their ASID and survive switches
+};
+
+struct AsidConfig {
+    AsidMode mode = AsidMode::Flush;
+    time_type flush_cost = 100;  // invalidating the TLBs on a switch in Flush mode
+};
+
+struct ContextStats {
+    uint64_t switches;
+    uint64_t flushes;
+    uint64_t flush_cost;
+    uint64_t reloads;      // misses on translations a flush dropped
+    uint64_t reload_cost;  // cost of those misses
+};
+
 class Mmu {
    public:
-    Mmu(std::unique_ptr<Tlb>&& tlb, time_type pagetable_cost, size_type page_size)
-        : tlb_{std::forward<decltype(tlb)>(tlb)},
-          pagetable_cost_{pagetable_cost},
-          offset_mask_{page_size - 1},
-          offset_bits_{static_cast<size_type>(std::log2(page_size))} {}
-    ~Mmu() = default;
+    Mmu(std::unique_ptr<Tlb>&& tlb, time_type pagetable_cost, size_type page_size);
+    // Addresses within a region use the pages of its class, all others the
+    // pages of the first class. Every class has TLBs of its own, probed in
+    // parallel by the hardware, so a lookup costs as much as in one of them.
+    Mmu(std::vector<PageClass>&& classes, std::vector<PageRegion>&& regions, time_type pagetable_cost);
+    ~Mmu();
 
     auto access(addr_type vaddr, bool prefetching) -> std::pair<bool, time_type>;
+    // run the address space asid from now on, returns the cost of the switch
+    auto switch_context(asid_type asid) -> time_type;
+    auto asid() const -> asid_type { return asid_; }
+    // drop the translation of vaddr in the address space asid, its page being unmapped
+    auto invalidate(addr_type vaddr, asid_type asid) -> void;
+
+    // print every access on stdout, on by default
+    auto set_verbose(bool verbose) -> void { verbose_ = verbose; }
+    // record every access in a machine-readable log, none by default
+    auto set_log(AccessLog* log) -> void { log_ = log; }
+    // walk a radix page table on misses, the page table cost is then per entry read
+    auto set_walker(std::unique_ptr<PageWalker>&& walker) -> void;
+    // back the pages of a class with limited frames, unlimited and never faulting by default
+    auto set_memory(size_type page_class, const MemoryConfig& config, std::unique_ptr<ReplacementPolicy>&& policy) -> void;
+
+    auto page_classes() const -> size_type { return static_cast<size_type>(pages_.size()); }
+    auto page_size(size_type page_class) const -> size_type { return size_type{1} << pages_[page_class].offset_bits; }
+    // page faults of the accesses so far, and how many of them read a page back in
+    auto faults() const -> uint64_t { return faults_; }
+    auto major_faults() const -> uint64_t { return major_faults_; }
+
+    // prefetch into a buffer probed after the TLBs miss, trained on those misses, none by default
+    auto set_prefetcher(const PrefetchConfig& config) -> void;
+    auto prefetch_stats() const -> const PrefetchStats& { return prefetch_stats_; }
+
+    // how context switches treat the TLBs, a flush of them by default
+    auto set_asid(const AsidConfig& config) -> void { asid_config_ = config; }
+    auto context_stats() const -> const ContextStats& { return context_stats_; }
+
+    // the counters of the TLB levels of a class, top down, all zero unless built with TLB_STATS
+    auto level_stats(size_type page_class) const -> std::vector<LevelStats>;
+    // classify the misses of every TLB level from now on
+    auto classify_misses() -> void;
+
+    // write out and read back what the accesses so far left cached, not their statistics
+    auto save(SnapshotWriter& writer) const -> void;
+    auto load(SnapshotReader& reader) -> void;
 
    private:
-    auto access_tlb(size_type vpn) -> std::optional<std::pair<addr_type, time_type>>;
-    auto access_pagetable(size_type vpn) -> std::pair<addr_type, time_type>;
+    // the class and its page geometry
+    struct Pages {
+        std::unique_ptr<Tlb> tlb;
+        addr_type offset_mask;
+        size_type offset_bits;
+        page_type frame_base;  // first frame handed out by the fake page table
+        size_type leaf_table;  // page table holding the entries of these pages
+        std::unique_ptr<PhysicalMemory> memory;
+        std::unique_ptr<Prefetcher> prefetcher;
+        std::unique_ptr<PrefetchBuffer> buffer;
+    };
+
+    auto pages_of(addr_type vaddr) -> Pages&;
+
+    auto access_tlb(Pages& pages, page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+    auto access_buffer(Pages& pages, page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+    auto access_pagetable(Pages& pages, addr_type vaddr, page_type vpn) -> std::pair<page_type, time_type>;
+    auto prefetch(Pages& pages, page_type vpn) -> void;
 
-    auto get_vpn(addr_type vaddr) -> size_type;
-    auto get_offset(addr_type vaddr) -> size_type;
-    auto fake_pagetable_map(size_type vpn) -> size_type;
+    auto fake_pagetable_map(Pages& pages, page_type vpn) -> page_type;
 
    private:
-    std::unique_ptr<Tlb> tlb_;
+    std::vector<Pages> pages_;
+    std::vector<PageRegion> regions_;  // sorted by start
     const time_type pagetable_cost_;
-    const addr_type offset_mask_;
-    const size_type offset_bits_;
+    std::unique_ptr<PageWalker> walker_;
+    uint64_t faults_;
+    uint64_t major_faults_;
+    time_type buffer_cost_;
+    PrefetchStats prefetch_stats_;
+    std::vector<page_type> predicted_;  // scratch of prefetch
+    uint64_t clock_;                    // cost of all accesses so far
+    AsidConfig asid_config_;
+    asid_type asid_;
+    ContextStats context_stats_;
+    std::vector<page_type> flushing_;        // scratch of switch_context
+    std::unordered_set<page_type> flushed_;  // tagged vpns dropped by flushes and not missed on since
+    bool verbose_;
+    AccessLog* log_;
 
    private:
     Mmu(const Mmu&) = delete;
@@ -0,0 +1,159 @@
+// multicore.cc
+// Replay of per-core traces through MMUs sharing their last TLB level
+// Author: Hank Bao
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "block_window.h"
+#include "multicore.h"
+
+// an invalidation posted to a core
+struct Shootdown {
+    addr_type vaddr;
+    asid_type asid;
+};
+
+// Invalidations posted by the other cores, polled by the owner on every
+// access without taking the lock while there are none.
+class Mailbox {
+   public:
+    Mailbox() : pending_{}, count_{0} {}
+    ~Mailbox() = default;
+
+    auto post(const Shootdown& shootdown) -> void {
+        std::lock_guard<std::mutex> lock{mutex_};
+        pending_.push_back(shootdown);
+        count_.store(pending_.size(), std::memory_order_release);
+    }
+
+    auto empty() const -> bool { return count_.load(std::memory_order_acquire) == 0; }
+
+    // move every posted invalidation to out
+    auto take(std::vector<Shootdown>& out) -> void {
+        out.clear();
+        std::lock_guard<std::mutex> lock{mutex_};
+        out.swap(pending_);
+        count_.store(0, std::memory_order_relaxed);
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<Shootdown> pending_;
+    std::atomic<size_t> count_;
+
+   private:
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+};
+
+auto parse_shootdown(const std::string& str, ShootdownConfig& shootdown) -> void {
+    auto fields = split_string(str, ":");
+    if (fields.size() > 2 || fields[0].empty()) {
+        std::fprintf(stderr, "Invalid shootdown costs: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    shootdown.ipi_cost = parse_cost(fields[0]);
+    if (fields.size() > 1) {
+        shootdown.handler_cost = parse_cost(fields[1]);
+    }
+}
+
+auto run_cores(const MmuConfig& config, const ShootdownConfig& shootdown, const std::vector<std::string>& traces,
+               TraceFormat format, const std::vector<addr_type>& prefetches) -> std::vector<CoreResult> {
+    const size_t cores = traces.size();
+    std::vector<CoreResult> results(cores, CoreResult{0, 0, 0, 0, 0, 0});
+
+    // built up front on this thread, the first core creates the shared levels
+    SharedPageTlbs shared{};
+    std::vector<std::unique_ptr<Mmu>> mmus{};
+    for (size_t c = 0; c < cores; ++c) {
+        auto mmu = make_mmu(config, &shared);
+        mmu->set_verbose(false);
+        for (const auto& addr : prefetches) {
+            mmu->access(addr, true);
+        }
+        mmus.push_back(std::move(mmu));
+    }
+
+    // opened and read through once here, so a missing or malformed trace exits before any core runs
+    std::vector<std::unique_ptr<TraceReader>> readers{};
+    std::vector<addr_type> block(kBlockSize);
+    for (size_t c = 0; c < cores; ++c) {
+        TraceReader check{traces[c], format};
+        while (check.read(block.data(), block.size()) != 0) {
+        }
+        readers.push_back(std::make_unique<TraceReader>(traces[c], format));
+    }
+
+    std::vector<Mailbox> mailboxes(cores);
+
+    // the core takes the interrupts of the invalidations in inbox
+    auto deliver = [&](size_t c, const std::vector<Shootdown>& inbox) {
+        for (const auto& s : inbox) {
+            mmus[c]->invalidate(s.vaddr, s.asid);
+        }
+        results[c].shootdowns_received += inbox.size();
+        results[c].shootdown_cost += inbox.size() * shootdown.handler_cost;
+        results[c].total_cost += inbox.size() * shootdown.handler_cost;
+    };
+
+    std::vector<std::thread> workers{};
+    for (size_t c = 0; c < cores; ++c) {
+        workers.emplace_back([&, c, reader = std::move(readers[c])] {
+            auto& mmu = *mmus[c];
+            auto& result = results[c];
+            std::vector<Shootdown> inbox{};
+
+            addr_type addr;
+            while (reader->next(addr)) {
+                if (!mailboxes[c].empty()) {
+                    mailboxes[c].take(inbox);
+                    deliver(c, inbox);
+                }
+
+                if (is_context_switch(addr)) {
+                    result.total_cost += mmu.switch_context(switch_asid(addr));
+                } else if (is_unmap(addr)) {
+                    Shootdown s{unmap_address(addr), mmu.asid()};
+                    mmu.invalidate(s.vaddr, s.asid);
+                    if (cores > 1) {
+                        for (size_t other = 0; other < cores; ++other) {
+                            if (other != c) {
+                                mailboxes[other].post(s);
+                            }
+                        }
+                        result.shootdowns_sent += 1;
+                        result.shootdown_cost += shootdown.ipi_cost;
+                        result.total_cost += shootdown.ipi_cost;
+                    }
+                } else {
+                    auto access = mmu.access(addr, false);
+                    if (access.first) {
+                        result.hits += 1;
+                    } else {
+                        result.misses += 1;
+                    }
+                    result.total_cost += access.second;
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // a core whose trace ended still takes the shootdowns posted to it afterwards
+    std::vector<Shootdown> inbox{};
+    for (size_t c = 0; c < cores; ++c) {
+        mailboxes[c].take(inbox);
+        deliver(c, inbox);
+    }
+
+    return results;
+}
@@ -0,0 +1,40 @@
+// multicore.h
+// Replay of per-core traces through MMUs sharing their last TLB level
+// Author: Hank Bao
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "def.h"
+#include "hierarchy.h"
+#include "trace.h"
+
+// what an unmap costs the cores
+struct ShootdownConfig {
+    time_type ipi_cost = 2000;     // the initiator interrupting the other cores and waiting for them
+    time_type handler_cost = 500;  // a target taking the interrupt and invalidating its entry
+};
+
+struct CoreResult {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t total_cost;  // shootdowns included
+    uint64_t shootdowns_sent;
+    uint64_t shootdowns_received;
+    uint64_t shootdown_cost;
+};
+
+// IPI[:HANDLER] into shootdown
+auto parse_shootdown(const std::string& str, ShootdownConfig& shootdown) -> void;
+
+// Every core replays its own trace on a thread of its own, through an MMU
+// of its own whose levels marked shared are one instance for all cores. An
+// unmap invalidates the page on its core and shoots it down on every other
+// one, which picks the invalidation up before its next access, or once
+// every core has finished if its own trace ended first. Cores keep
+// no common clock: with a shared level the interleaving of the cores, and
+// so the results, follow the scheduling of the host.
+auto run_cores(const MmuConfig& config, const ShootdownConfig& shootdown, const std::vector<std::string>& traces,
+               TraceFormat format, const std::vector<addr_type>& prefetches) -> std::vector<CoreResult>;
@@ -0,0 +1,110 @@
+// page_walk.cc
+// Radix page-table walk with paging-structure and data caches
+// Author: Hank Bao
+
+#include <algorithm>
+
+#include "page_walk.h"
+
+// page-table entries per 64-byte line, as a shift
+static constexpr size_type kEntriesPerLineBits = 3;
+static constexpr size_type kLineWays = 8;
+
+// the address bits above bits, 0 if there are none
+static auto prefix(addr_type vaddr, size_type bits) -> page_type {
+    return bits >= 64 ? 0 : vaddr >> bits;
+}
+
+PageWalker::PageWalker(const WalkConfig& config, size_type base_bits, time_type memory_cost)
+    : levels_{config.levels},
+      base_bits_{base_bits},
+      pwc_cost_{config.pwc_cost},
+      cache_cost_{config.cache_cost},
+      memory_cost_{memory_cost},
+      pwc_{},
+      lines_{config.cache_lines, std::min(config.cache_lines, kLineWays), 0} {
+    pwc_.push_back(nullptr);
+    for (size_type t = 1; t < levels_; ++t) {
+        pwc_.push_back(std::make_unique<Cache>(config.pwc_entries, 0, 0));
+    }
+}
+
+auto PageWalker::walk(addr_type vaddr, size_type leaf, asid_type asid) -> time_type {
+    const size_type top = levels_ - 1;
+    // every address space has page tables of its own, the keys leave bits 48 and up free for its ASID
+    const page_type space = static_cast<page_type>(asid) << 48;
+    leaf = std::min(leaf, top);
+
+    // the lowest cached upper entry skips the most tables, all are probed at once
+    time_type cost = leaf < top ? pwc_cost_ : 0;
+    size_type start = top;
+    for (size_type t = leaf + 1; t <= top; ++t) {
+        if (pwc_[t]->lookup(prefix(vaddr, shift(t)) | space) != nullptr) {
+            start = t - 1;
+            break;
+        }
+    }
+
+    for (size_type t = start + 1; t-- > leaf;) {
+        // the line of the entry, tagged with its table
+        page_type line = prefix(vaddr, shift(t) + kEntriesPerLineBits) | space | (page_type{t} << 61);
+        if (lines_.lookup(line) != nullptr) {
+            cost += cache_cost_;
+        } else {
+            cost += memory_cost_;
+            lines_.insert(line, 0, true);
+        }
+
+        if (t > leaf) {
+            pwc_[t]->insert(prefix(vaddr, shift(t)) | space, 0, true);
+        }
+    }
+
+    return cost;
+}
+
+auto PageWalker::estimate(addr_type vaddr, size_type leaf, asid_type asid) const -> time_type {
+    const size_type top = levels_ - 1;
+    const page_type space = static_cast<page_type>(asid) << 48;
+    leaf = std::min(leaf, top);
+
+    // the walk above, probing instead of looking up and filling nothing
+    time_type cost = leaf < top ? pwc_cost_ : 0;
+    size_type start = top;
+    for (size_type t = leaf + 1; t <= top; ++t) {
+        if (pwc_[t]->probe(prefix(vaddr, shift(t)) | space)) {
+            start = t - 1;
+            break;
+        }
+    }
+
+    for (size_type t = start + 1; t-- > leaf;) {
+        page_type line = prefix(vaddr, shift(t) + kEntriesPerLineBits) | space | (page_type{t} << 61);
+        cost += lines_.probe(line) ? cache_cost_ : memory_cost_;
+    }
+
+    return cost;
+}
+
+auto PageWalker::flush() -> void {
+    std::vector<page_type> flushed{};
+    for (size_type t = 1; t < levels_; ++t) {
+        pwc_[t]->flush(flushed);
+    }
+}
+
+auto PageWalker::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint64_t>(levels_);
+    for (size_type t = 1; t < levels_; ++t) {
+        pwc_[t]->save(writer);
+    }
+    lines_.save(writer);
+}
+
+auto PageWalker::load(SnapshotReader& reader) -> void {
+    reader.expect<uint64_t>(levels_, "page-table levels");
+    for (size_type t = 1; t < levels_; ++t) {
+        pwc_[t]->load(reader);
+    }
+    lines_.load(reader);
+}
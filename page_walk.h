@@ -0,0 +1,67 @@
+// page_walk.h
+// Radix page-table walk with paging-structure and data caches
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "def.h"
+#include "policy_lru.h"
+#include "tlb_array.h"
+
+// shape of the page table and of the caches a walk goes through
+struct WalkConfig {
+    uint32_t levels = 0;          // 4 or 5, 0 charges a flat page table cost instead
+    uint32_t pwc_entries = 32;    // entries of the paging-structure cache of every upper level
+    uint32_t cache_lines = 512;   // page-table lines held by the data caches, a power of 2
+    uint32_t pwc_cost = 1;        // probing the paging-structure caches, once per walk
+    uint32_t cache_cost = 5;      // reading a page-table entry from the data caches
+};
+
+// An x86-64 style radix page table: every table holds 512 entries and
+// resolves 9 bits of the address above the offset of the smallest page,
+// table 0 holding the entries of those pages. A larger page ends the walk
+// at the table whose entries cover it.
+//
+// The entries of the upper tables met by earlier walks are kept in one
+// paging-structure cache per table; the walk starts below the lowest one
+// that hits. Every entry read then costs cache_cost if its 64-byte line is
+// among the page-table lines in the data caches, or memory_cost otherwise.
+class PageWalker {
+   public:
+    PageWalker(const WalkConfig& config, size_type base_bits, time_type memory_cost);
+    ~PageWalker() = default;
+
+    // cost of translating vaddr of the address space asid mapped by an entry of the given table
+    auto walk(addr_type vaddr, size_type leaf, asid_type asid) -> time_type;
+    // what walk would cost now, leaving the caches as they are
+    auto estimate(addr_type vaddr, size_type leaf, asid_type asid) const -> time_type;
+    // drop the paging-structure caches, the page-table lines stay in the data caches
+    auto flush() -> void;
+
+    // write out and read back every cache of the walk, see Snapshot
+    auto save(SnapshotWriter& writer) const -> void;
+    auto load(SnapshotReader& reader) -> void;
+
+   private:
+    typedef TlbArray<ReplacementPolicyLru> Cache;
+
+    // bits of the address resolved below table t
+    auto shift(size_type t) const -> size_type { return base_bits_ + 9 * t; }
+
+   private:
+    const size_type levels_;
+    const size_type base_bits_;
+    const time_type pwc_cost_;
+    const time_type cache_cost_;
+    const time_type memory_cost_;
+    std::vector<std::unique_ptr<Cache>> pwc_;  // by table, none for table 0
+    Cache lines_;
+
+   private:
+    PageWalker(const PageWalker&) = delete;
+    PageWalker& operator=(const PageWalker&) = delete;
+};
@@ -0,0 +1,53 @@
+// physical_memory.cc
+// Page table backed by a limited number of physical frames
+// Author: Hank Bao
+
+#include "physical_memory.h"
+
+PhysicalMemory::PhysicalMemory(const MemoryConfig& config, page_type frame_base,
+                               std::unique_ptr<ReplacementPolicy>&& policy)
+    : frames_{config.frames},
+      frame_base_{frame_base},
+      minor_cost_{config.minor_cost},
+      major_cost_{config.major_cost},
+      policy_{std::move(policy)},
+      allocated_{0},
+      owners_(config.frames, kNoPage),
+      entries_{} {}
+
+auto PhysicalMemory::resident(page_type vpn) const -> std::optional<page_type> {
+    auto it = entries_.find(vpn);
+    if (it == entries_.end() || !it->second.second) {
+        return std::nullopt;
+    }
+
+    return it->second.first;
+}
+
+auto PhysicalMemory::translate(page_type vpn) -> std::pair<page_type, std::optional<PageFault>> {
+    auto [it, inserted] = entries_.try_emplace(vpn, TlbEntry{0, false});
+    TlbEntry& entry = it->second;
+
+    if (entry.second) {
+        policy_->touch(0, static_cast<size_type>(entry.first - frame_base_));
+        return std::make_pair(entry.first, std::nullopt);
+    }
+
+    PageFault fault{!inserted, inserted ? minor_cost_ : major_cost_, std::nullopt};
+
+    size_type frame;
+    if (allocated_ < frames_) {
+        frame = allocated_++;
+    } else {
+        // swap the victim out, its entry stays behind invalid
+        frame = policy_->victim(0);
+        fault.evicted = owners_[frame];
+        entries_[owners_[frame]].second = false;
+    }
+
+    owners_[frame] = vpn;
+    entry = TlbEntry{frame_base_ + frame, true};
+    policy_->fill(0, frame);
+
+    return std::make_pair(entry.first, fault);
+}
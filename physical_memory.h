@@ -0,0 +1,64 @@
+// physical_memory.h
+// Page table backed by a limited number of physical frames
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "def.h"
+#include "policy.h"
+#include "utils.h"
+
+// physical memory behind the page table of every page size
+struct MemoryConfig {
+    uint32_t frames = 0;              // frames of every page size, 0 for unlimited memory without faults
+    Policy policy = Policy::LRU;      // picks the page swapped out when memory is full
+    uint32_t minor_cost = 1000;       // first touch of a page, a zero-filled frame
+    uint32_t major_cost = 100000;     // a page swapped out before, read back in
+};
+
+// outcome of translating one page
+struct PageFault {
+    bool major;                       // the page had been swapped out
+    time_type cost;
+    std::optional<page_type> evicted; // the page swapped out to make room
+};
+
+// The page table of one page size with its frames. Every entry is a
+// TlbEntry whose valid bit tells whether the page is resident; an entry
+// left invalid keeps the page's last frame only for the record. Frames are
+// handed out lowest first and, once none is free, the policy picks the
+// frame to reclaim, seeing all of memory as a single set. The policy hears
+// about every walk that finds a page, like the accessed bit set by the
+// hardware, not about TLB hits.
+class PhysicalMemory {
+   public:
+    PhysicalMemory(const MemoryConfig& config, page_type frame_base, std::unique_ptr<ReplacementPolicy>&& policy);
+    ~PhysicalMemory() = default;
+
+    // the frame of the resident page, faulting it in first if it is not
+    auto translate(page_type vpn) -> std::pair<page_type, std::optional<PageFault>>;
+    // the frame of the page if it is resident, nobody learns about it
+    auto resident(page_type vpn) const -> std::optional<page_type>;
+
+   private:
+    static constexpr page_type kNoPage = ~page_type{0};
+
+    const size_type frames_;
+    const page_type frame_base_;
+    const time_type minor_cost_;
+    const time_type major_cost_;
+    std::unique_ptr<ReplacementPolicy> policy_;
+    size_type allocated_;                          // frames below are taken
+    std::vector<page_type> owners_;                // vpn in every frame
+    std::unordered_map<page_type, TlbEntry> entries_;
+
+   private:
+    PhysicalMemory(const PhysicalMemory&) = delete;
+    PhysicalMemory& operator=(const PhysicalMemory&) = delete;
+};
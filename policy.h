@@ -4,19 +4,36 @@
 
 #pragma once
 
-#include <map>
-#include <optional>
-
 #include "def.h"
 
+class SnapshotReader;
+class SnapshotWriter;
+
+// A policy works on a TLB of sets * ways slots and decides within one set
+// at a time: the table fills the free ways of a set itself and asks the
+// policy for a victim way once every way of that set is taken. A way whose
+// entry is invalidated is dropped from the policy and filled again before
+// the set asks for a victim, and a flush clears the policy along with every
+// set. A fully associative TLB is simply a single set.
 class ReplacementPolicy {
    public:
     ReplacementPolicy() = default;
     virtual ~ReplacementPolicy() = default;
 
-    virtual auto replace(
-        std::map<size_type, TlbEntry>& cache, size_type cache_size, size_type vpn,
-        size_type pfn, bool valid) -> std::optional<std::pair<size_type, TlbEntry>> = 0;
+    // a new entry has been stored in the way of the set
+    virtual auto fill(size_type set, size_type way) -> void = 0;
+    // pick the way of the set whose entry is evicted next, the set is full
+    virtual auto victim(size_type set) -> size_type = 0;
+    // the entry in the way of the set has been hit by a lookup
+    virtual auto touch(size_type set, size_type way) -> void {}
+    // the entry in the way of the set has been invalidated, the way is not a victim until filled again
+    virtual auto drop(size_type set, size_type way) -> void = 0;
+    // every set has been emptied, the table fills its ways from the first again
+    virtual auto clear() -> void = 0;
+
+    // write out and read back everything the policy keeps, see Snapshot
+    virtual auto save(SnapshotWriter& writer) const -> void = 0;
+    virtual auto load(SnapshotReader& reader) -> void = 0;
 
    private:
     ReplacementPolicy(const ReplacementPolicy&) = delete;
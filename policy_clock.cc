@@ -0,0 +1,54 @@
+// policy_clock.cc
+// Replacement Policy by CLOCK
+// Author: Hank Bao
+
+#include <algorithm>
+
+#include "policy_clock.h"
+#include "snapshot.h"
+
+auto ReplacementPolicyClock::fill(size_type set, size_type way) -> void {
+    // the miss bringing the entry in is its first reference
+    word(set, way) |= uint64_t{1} << (way % 64);
+}
+
+auto ReplacementPolicyClock::victim(size_type set) -> size_type {
+    auto& hand = hands_[set];
+    for (;;) {
+        auto way = hand;
+        hand = hand + 1 == ways_ ? 0 : hand + 1;
+
+        auto& bits = word(set, way);
+        const auto bit = uint64_t{1} << (way % 64);
+        if ((bits & bit) == 0) {
+            return way;
+        }
+        // a second chance, the hand comes back after a full turn
+        bits &= ~bit;
+    }
+}
+
+auto ReplacementPolicyClock::touch(size_type set, size_type way) -> void {
+    word(set, way) |= uint64_t{1} << (way % 64);
+}
+
+auto ReplacementPolicyClock::drop(size_type set, size_type way) -> void {
+    word(set, way) &= ~(uint64_t{1} << (way % 64));
+}
+
+auto ReplacementPolicyClock::clear() -> void {
+    std::fill(referenced_.begin(), referenced_.end(), 0);
+    std::fill(hands_.begin(), hands_.end(), 0);
+}
+
+auto ReplacementPolicyClock::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint8_t>('C');
+    writer.put_vector(referenced_);
+    writer.put_vector(hands_);
+}
+
+auto ReplacementPolicyClock::load(SnapshotReader& reader) -> void {
+    reader.expect<uint8_t>('C', "replacement policy");
+    reader.get_vector(referenced_, "CLOCK ways");
+    reader.get_vector(hands_, "CLOCK sets");
+}
@@ -0,0 +1,49 @@
+// policy_clock.h
+// Replacement Policy implementation as CLOCK
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "policy.h"
+
+// Second chance: every way has a reference bit, set when it is filled or
+// hit, and every set a hand sweeping its ways in a circle. The victim is
+// the first way under the hand whose bit is clear, the bits it passes over
+// being cleared, so each bit set is cleared at most once and a victim
+// costs O(1) amortized. The bits of a set are packed into 64-bit words.
+class ReplacementPolicyClock : public ReplacementPolicy {
+   public:
+    ReplacementPolicyClock(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicy{},
+          ways_{ways},
+          words_{(ways + 63) / 64},
+          referenced_(static_cast<size_t>(sets) * words_),
+          hands_(sets) {}
+    virtual ~ReplacementPolicyClock() = default;
+
+    virtual auto fill(size_type set, size_type way) -> void override;
+    virtual auto victim(size_type set) -> size_type override;
+    virtual auto touch(size_type set, size_type way) -> void override;
+    virtual auto drop(size_type set, size_type way) -> void override;
+    virtual auto clear() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
+
+   private:
+    auto word(size_type set, size_type way) -> uint64_t& {
+        return referenced_[static_cast<size_t>(set) * words_ + way / 64];
+    }
+
+   private:
+    const size_type ways_;
+    const size_type words_;  // per set
+    std::vector<uint64_t> referenced_;
+    std::vector<size_type> hands_;
+
+   private:
+    ReplacementPolicyClock(const ReplacementPolicyClock&) = delete;
+    ReplacementPolicyClock& operator=(const ReplacementPolicyClock&) = delete;
+};
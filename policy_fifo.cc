@@ -2,33 +2,71 @@
 // Replacement Policy by FIFO
 // Author: Hank Bao
 
+#include <algorithm>
 #include <cassert>
-#include <utility>
 
 #include "policy_fifo.h"
+#include "snapshot.h"
 
-auto ReplacementPolicyFifo::replace(
-    std::map<size_type, TlbEntry>& cache, size_type cache_size,
-    size_type vpn, size_type pfn, bool valid) -> std::optional<std::pair<size_type, TlbEntry>> {
-    // save pfn in the cache
-    cache[vpn] = std::make_pair(pfn, valid);
+auto ReplacementPolicyFifo::fill(size_type set, size_type way) -> void {
+    auto& queue = queues_[set];
+    assert(queue.count < ways_);
 
-    // save vpn in the queue for bookkeeping
-    queue_.push_back(vpn);
+    // save way at the tail of the ring of its set for bookkeeping
+    auto tail = queue.head + queue.count;
+    if (tail >= ways_) {
+        tail -= ways_;
+    }
+
+    ring_[static_cast<size_t>(set) * ways_ + tail] = way;
+    queue.count += 1;
+}
 
-    // evict the first vpn if the cache is full
-    if (cache.size() > cache_size) {
-        auto front = queue_.front();
-        queue_.erase(queue_.begin());
+auto ReplacementPolicyFifo::victim(size_type set) -> size_type {
+    auto& queue = queues_[set];
+    assert(queue.count > 0);
 
-        auto it = cache.find(front);
-        assert(it != cache.end());
+    // evict the first way filled
+    auto front = ring_[static_cast<size_t>(set) * ways_ + queue.head];
+    queue.head = queue.head + 1 == ways_ ? 0 : queue.head + 1;
+    queue.count -= 1;
 
-        auto kv = *it;
-        cache.erase(it);
+    return front;
+}
+
+auto ReplacementPolicyFifo::drop(size_type set, size_type way) -> void {
+    auto& queue = queues_[set];
+    auto* ring = &ring_[static_cast<size_t>(set) * ways_];
 
-        return kv;
-    } else {
-        return std::nullopt;
+    // close the gap the way leaves in the queue, keeping the others in filling order
+    size_type pos = queue.head;
+    for (size_type i = 0; i < queue.count; ++i) {
+        auto next = pos + 1 == ways_ ? 0 : pos + 1;
+        if (ring[pos] == way) {
+            for (size_type j = i + 1; j < queue.count; ++j) {
+                ring[pos] = ring[next];
+                pos = next;
+                next = next + 1 == ways_ ? 0 : next + 1;
+            }
+            queue.count -= 1;
+            return;
+        }
+        pos = next;
     }
 }
+
+auto ReplacementPolicyFifo::clear() -> void {
+    std::fill(queues_.begin(), queues_.end(), Queue{});
+}
+
+auto ReplacementPolicyFifo::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint8_t>('F');
+    writer.put_vector(ring_);
+    writer.put_vector(queues_);
+}
+
+auto ReplacementPolicyFifo::load(SnapshotReader& reader) -> void {
+    reader.expect<uint8_t>('F', "replacement policy");
+    reader.get_vector(ring_, "FIFO ways");
+    reader.get_vector(queues_, "FIFO sets");
+}
@@ -8,17 +8,31 @@
 
 #include "policy.h"
 
+// Each set queues its ways in filling order in a fixed ring of ways slots,
+// allocated up front, so both filling and evicting are O(1).
 class ReplacementPolicyFifo : public ReplacementPolicy {
    public:
-    ReplacementPolicyFifo(size_type capacity) : ReplacementPolicy{}, queue_{} {}
+    ReplacementPolicyFifo(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicy{}, ways_{ways}, ring_(static_cast<size_t>(sets) * ways), queues_(sets) {}
     virtual ~ReplacementPolicyFifo() = default;
 
-    virtual auto replace(
-        std::map<size_type, TlbEntry>& cache, size_type cache_size, size_type vpn,
-        size_type pfn, bool valid) -> std::optional<std::pair<size_type, TlbEntry>> override;
+    virtual auto fill(size_type set, size_type way) -> void override;
+    virtual auto victim(size_type set) -> size_type override;
+    virtual auto drop(size_type set, size_type way) -> void override;
+    virtual auto clear() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
 
    private:
-    std::vector<size_type> queue_;
+    struct Queue {
+        size_type head = 0;  // position of the oldest way in the ring
+        size_type count = 0;
+    };
+
+   private:
+    const size_type ways_;
+    std::vector<size_type> ring_;
+    std::vector<Queue> queues_;
 
    private:
     ReplacementPolicyFifo(const ReplacementPolicyFifo&) = delete;
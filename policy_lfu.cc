@@ -0,0 +1,74 @@
+// policy_lfu.cc
+// Replacement Policy by LFU with aging
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cassert>
+
+#include "policy_lfu.h"
+#include "snapshot.h"
+
+auto ReplacementPolicyLfu::fill(size_type set, size_type way) -> void {
+    // the miss bringing the entry in is its first reference
+    lists_.push_front(set, way, 1);
+    age(set);
+}
+
+auto ReplacementPolicyLfu::victim(size_type set) -> size_type {
+    for (size_type count = 0; count <= kMaxCount; ++count) {
+        if (!lists_.empty(set, count)) {
+            auto way = lists_.oldest(set, count);
+            lists_.unlink(set, way);
+            return way;
+        }
+    }
+
+    assert(false);
+    return 0;
+}
+
+auto ReplacementPolicyLfu::touch(size_type set, size_type way) -> void {
+    auto count = lists_.list_of(set, way);
+    lists_.unlink(set, way);
+    lists_.push_front(set, way, count == kMaxCount ? count : count + 1);
+    age(set);
+}
+
+auto ReplacementPolicyLfu::age(size_type set) -> void {
+    auto& references = references_[set];
+    references += 1;
+    if (references < period_) {
+        return;
+    }
+    references = 0;
+
+    // lower counts first, so every list is emptied before the halves of higher ones join it
+    for (size_type count = 1; count <= kMaxCount; ++count) {
+        while (!lists_.empty(set, count)) {
+            auto way = lists_.oldest(set, count);
+            lists_.unlink(set, way);
+            lists_.push_front(set, way, count / 2);
+        }
+    }
+}
+
+auto ReplacementPolicyLfu::drop(size_type set, size_type way) -> void {
+    lists_.unlink(set, way);
+}
+
+auto ReplacementPolicyLfu::clear() -> void {
+    lists_.clear();
+    std::fill(references_.begin(), references_.end(), 0);
+}
+
+auto ReplacementPolicyLfu::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint8_t>('U');
+    lists_.save(writer);
+    writer.put_vector(references_);
+}
+
+auto ReplacementPolicyLfu::load(SnapshotReader& reader) -> void {
+    reader.expect<uint8_t>('U', "replacement policy");
+    lists_.load(reader, "LFU ways");
+    reader.get_vector(references_, "LFU sets");
+}
@@ -0,0 +1,48 @@
+// policy_lfu.h
+// Replacement Policy implementation as LFU with aging
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "policy.h"
+#include "policy_lists.h"
+
+// Every way counts its references in 4 bits, saturating at kMaxCount, and
+// the victim is the least recently filled or hit way of the lowest count.
+// The counts of a set are halved every kAgingPeriod references per way, so
+// entries that were hot once cannot stay forever. Ways are kept in one list
+// per count, which makes a victim or a hit O(1) and aging O(ways) once in
+// a while.
+class ReplacementPolicyLfu : public ReplacementPolicy {
+   public:
+    ReplacementPolicyLfu(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicy{}, period_{ways * kAgingPeriod}, lists_{sets, ways, kMaxCount + 1}, references_(sets) {}
+    virtual ~ReplacementPolicyLfu() = default;
+
+    virtual auto fill(size_type set, size_type way) -> void override;
+    virtual auto victim(size_type set) -> size_type override;
+    virtual auto touch(size_type set, size_type way) -> void override;
+    virtual auto drop(size_type set, size_type way) -> void override;
+    virtual auto clear() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
+
+   private:
+    static constexpr size_type kMaxCount = 15;
+    static constexpr size_type kAgingPeriod = 16;
+
+    // count a reference to the set, halving its counts once a period
+    auto age(size_type set) -> void;
+
+   private:
+    const size_type period_;
+    WayLists lists_;
+    std::vector<size_type> references_;  // of every set since it last aged
+
+   private:
+    ReplacementPolicyLfu(const ReplacementPolicyLfu&) = delete;
+    ReplacementPolicyLfu& operator=(const ReplacementPolicyLfu&) = delete;
+};
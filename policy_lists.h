@@ -0,0 +1,111 @@
+// policy_lists.h
+// Recency lists of the ways of every set, for policies ranking ways in a few classes
+// Author: Hank Bao
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "def.h"
+#include "snapshot.h"
+
+// Every set keeps its ways in a few doubly linked lists, one per class of
+// a small counter such as a re-reference prediction or a use count, a way
+// being in at most one of them. The links are way numbers stored per TLB
+// slot as the LRU policy does, so moving a way between lists and finding
+// the oldest way of a class are O(1), where scanning the counters of a
+// wide set would be O(ways).
+class WayLists {
+   public:
+    WayLists(size_type sets, size_type ways, size_type lists)
+        : ways_{ways}, lists_{lists}, links_(static_cast<size_t>(sets) * ways), ends_(static_cast<size_t>(sets) * lists) {}
+    ~WayLists() = default;
+
+    // the list the way is in, the way must be in one
+    auto list_of(size_type set, size_type way) const -> size_type { return link(set, way).list; }
+    auto empty(size_type set, size_type list) const -> bool { return ends(set, list).head == kNil; }
+    // the way pushed into the list the longest ago, the list must not be empty
+    auto oldest(size_type set, size_type list) const -> size_type { return ends(set, list).tail; }
+
+    auto push_front(size_type set, size_type way, size_type list) -> void {
+        auto& e = ends(set, list);
+        auto& l = link(set, way);
+
+        l.prev = kNil;
+        l.next = e.head;
+        l.list = static_cast<uint8_t>(list);
+        if (e.head != kNil) {
+            link(set, e.head).prev = way;
+        } else {
+            e.tail = way;
+        }
+        e.head = way;
+    }
+
+    auto unlink(size_type set, size_type way) -> void {
+        auto& l = link(set, way);
+        auto& e = ends(set, l.list);
+
+        if (l.prev != kNil) {
+            link(set, l.prev).next = l.next;
+        } else {
+            e.head = l.next;
+        }
+
+        if (l.next != kNil) {
+            link(set, l.next).prev = l.prev;
+        } else {
+            e.tail = l.prev;
+        }
+
+        l.prev = kNil;
+        l.next = kNil;
+    }
+
+    // every way of every set is in no list
+    auto clear() -> void {
+        std::fill(links_.begin(), links_.end(), Link{});
+        std::fill(ends_.begin(), ends_.end(), Ends{});
+    }
+
+    auto save(SnapshotWriter& writer) const -> void {
+        writer.put_vector(links_);
+        writer.put_vector(ends_);
+    }
+
+    auto load(SnapshotReader& reader, const char* what) -> void {
+        reader.get_vector(links_, what);
+        reader.get_vector(ends_, what);
+    }
+
+   private:
+    static constexpr size_type kNil = ~size_type{0};
+
+    struct Link {
+        size_type prev = kNil;  // way pushed later into the same list
+        size_type next = kNil;  // way pushed earlier
+        uint8_t list = 0;
+    };
+
+    struct Ends {
+        size_type head = kNil;  // newest way of the list
+        size_type tail = kNil;  // oldest way of the list
+    };
+
+    auto link(size_type set, size_type way) -> Link& { return links_[static_cast<size_t>(set) * ways_ + way]; }
+    auto link(size_type set, size_type way) const -> const Link& { return links_[static_cast<size_t>(set) * ways_ + way]; }
+    auto ends(size_type set, size_type list) -> Ends& { return ends_[static_cast<size_t>(set) * lists_ + list]; }
+    auto ends(size_type set, size_type list) const -> const Ends& { return ends_[static_cast<size_t>(set) * lists_ + list]; }
+
+   private:
+    const size_type ways_;
+    const size_type lists_;
+    std::vector<Link> links_;
+    std::vector<Ends> ends_;
+
+   private:
+    WayLists(const WayLists&) = delete;
+    WayLists& operator=(const WayLists&) = delete;
+};
@@ -2,29 +2,83 @@
 // Replacement Policy by LRU
 // Author: Hank Bao
 
+#include <algorithm>
 #include <cassert>
-#include <utility>
 
 #include "policy_lru.h"
+#include "snapshot.h"
 
-auto ReplacementPolicyLru::replace(
-    std::map<size_type, TlbEntry>& cache, size_type cache_size,
-    size_type vpn, size_type pfn, bool valid) -> std::optional<std::pair<size_type, TlbEntry>> {
-    // save pfn in the cache
-    cache[vpn] = std::make_pair(pfn, valid);
+auto ReplacementPolicyLru::fill(size_type set, size_type way) -> void {
+    // a new entry is the most recently used one, the victim has been unlinked already
+    push_front(set, way);
+}
+
+auto ReplacementPolicyLru::victim(size_type set) -> size_type {
+    auto way = ends_[set].tail;
+    assert(way != kNil);
+
+    unlink(set, way);
+    return way;
+}
 
-    // save (vpn, pfn, valid) in the lru for bookkeeping and get the evictee simultaneously
-    auto evictee = lru_.insert(vpn, std::make_pair(pfn, valid));
-    if (evictee) {
-        assert(cache.size() > cache_size);
+auto ReplacementPolicyLru::touch(size_type set, size_type way) -> void {
+    if (ends_[set].head != way) {
+        unlink(set, way);
+        push_front(set, way);
+    }
+}
+
+auto ReplacementPolicyLru::push_front(size_type set, size_type way) -> void {
+    auto& ends = ends_[set];
+    auto& l = link(set, way);
+
+    l.prev = kNil;
+    l.next = ends.head;
+    if (ends.head != kNil) {
+        link(set, ends.head).prev = way;
+    } else {
+        ends.tail = way;
+    }
+    ends.head = way;
+}
 
-        auto it = cache.find(evictee->first);
-        assert(it != cache.end());
+auto ReplacementPolicyLru::unlink(size_type set, size_type way) -> void {
+    auto& ends = ends_[set];
+    auto& l = link(set, way);
 
-        cache.erase(it);
+    if (l.prev != kNil) {
+        link(set, l.prev).next = l.next;
+    } else {
+        ends.head = l.next;
+    }
 
-        return evictee;
+    if (l.next != kNil) {
+        link(set, l.next).prev = l.prev;
     } else {
-        return std::nullopt;
+        ends.tail = l.prev;
     }
+
+    l.prev = kNil;
+    l.next = kNil;
+}
+
+auto ReplacementPolicyLru::drop(size_type set, size_type way) -> void {
+    unlink(set, way);
+}
+
+auto ReplacementPolicyLru::clear() -> void {
+    std::fill(links_.begin(), links_.end(), Link{});
+    std::fill(ends_.begin(), ends_.end(), Ends{});
+}
+
+auto ReplacementPolicyLru::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint8_t>('L');
+    writer.put_vector(links_);
+    writer.put_vector(ends_);
+}
+
+auto ReplacementPolicyLru::load(SnapshotReader& reader) -> void {
+    reader.expect<uint8_t>('L', "replacement policy");
+    reader.get_vector(links_, "LRU ways");
+    reader.get_vector(ends_, "LRU sets");
 }
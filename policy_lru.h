@@ -4,20 +4,48 @@
 
 #pragma once
 
+#include <vector>
+
 #include "policy.h"
-#include "lru_cache.h"
 
+// Each set keeps its ways in a doubly linked recency list whose links are
+// way numbers stored per TLB slot, parallel to the TLB's entry table, so
+// hits, fills and evictions are all O(1) and never allocate.
 class ReplacementPolicyLru : public ReplacementPolicy {
    public:
-    ReplacementPolicyLru(size_type capacity) : ReplacementPolicy{}, lru_{capacity} {}
+    ReplacementPolicyLru(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicy{}, ways_{ways}, links_(static_cast<size_t>(sets) * ways), ends_(sets) {}
     virtual ~ReplacementPolicyLru() = default;
 
-    virtual auto replace(
-        std::map<size_type, TlbEntry>& cache, size_type cache_size, size_type vpn,
-        size_type pfn, bool valid) -> std::optional<std::pair<size_type, TlbEntry>> override;
+    virtual auto fill(size_type set, size_type way) -> void override;
+    virtual auto victim(size_type set) -> size_type override;
+    virtual auto touch(size_type set, size_type way) -> void override;
+    virtual auto drop(size_type set, size_type way) -> void override;
+    virtual auto clear() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
+
+   private:
+    static constexpr size_type kNil = ~size_type{0};
+
+    struct Link {
+        size_type prev = kNil;  // more recently used way
+        size_type next = kNil;  // less recently used way
+    };
+
+    struct Ends {
+        size_type head = kNil;  // most recently used way
+        size_type tail = kNil;  // least recently used way
+    };
+
+    auto link(size_type set, size_type way) -> Link& { return links_[static_cast<size_t>(set) * ways_ + way]; }
+    auto push_front(size_type set, size_type way) -> void;
+    auto unlink(size_type set, size_type way) -> void;
 
    private:
-    lru_cache<size_type, TlbEntry> lru_;
+    const size_type ways_;
+    std::vector<Link> links_;
+    std::vector<Ends> ends_;
 
    private:
     ReplacementPolicyLru(const ReplacementPolicyLru&) = delete;
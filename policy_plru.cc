@@ -0,0 +1,72 @@
+// policy_plru.cc
+// Replacement Policy by tree pseudo-LRU
+// Author: Hank Bao
+
+#include <algorithm>
+
+#include "policy_plru.h"
+#include "snapshot.h"
+
+auto ReplacementPolicyPlru::fill(size_type set, size_type way) -> void {
+    point_away(set, way);
+}
+
+auto ReplacementPolicyPlru::victim(size_type set) -> size_type {
+    // follow the bits down from the root, the leaf reached is the victim; the bits are as good as
+    // random to the branch predictor, so the walk selects instead of branching
+    const auto* words = &bits_[static_cast<size_t>(set) * words_];
+    const uint64_t top = words[0];  // the first six levels of the tree
+    size_type node = 1;
+    size_type first = 0;
+    for (size_type span = leaves_; span > 1; span /= 2) {
+        const auto half = span / 2;
+        const auto bits = node < 64 ? top : words[node / 64];
+        const size_type right = ((bits >> (node % 64)) & 1) & (first + half < ways_);
+        node = 2 * node + right;
+        first += half & (0 - right);
+    }
+
+    return first;
+}
+
+auto ReplacementPolicyPlru::touch(size_type set, size_type way) -> void {
+    point_away(set, way);
+}
+
+auto ReplacementPolicyPlru::point_away(size_type set, size_type way) -> void {
+    auto* words = &bits_[static_cast<size_t>(set) * words_];
+    // the first six levels share a word, written once; every level below has words of its own
+    uint64_t top_mask = 0;
+    uint64_t top_bits = 0;
+    for (size_type node = leaves_ + way; node > 1; node /= 2) {
+        const auto parent = node / 2;
+        const auto mask = uint64_t{1} << (parent % 64);
+        // coming up from the left child the parent points right, and the other way round
+        const auto bits = mask & (0 - static_cast<uint64_t>((node % 2) ^ 1));
+        if (parent < 64) {
+            top_mask |= mask;
+            top_bits |= bits;
+        } else {
+            words[parent / 64] = (words[parent / 64] & ~mask) | bits;
+        }
+    }
+    words[0] = (words[0] & ~top_mask) | top_bits;
+}
+
+auto ReplacementPolicyPlru::drop(size_type set, size_type way) -> void {
+    // the bits keep pointing wherever they do, the way is filled again before the next victim
+}
+
+auto ReplacementPolicyPlru::clear() -> void {
+    std::fill(bits_.begin(), bits_.end(), 0);
+}
+
+auto ReplacementPolicyPlru::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint8_t>('P');
+    writer.put_vector(bits_);
+}
+
+auto ReplacementPolicyPlru::load(SnapshotReader& reader) -> void {
+    reader.expect<uint8_t>('P', "replacement policy");
+    reader.get_vector(bits_, "PLRU sets");
+}
@@ -0,0 +1,53 @@
+// policy_plru.h
+// Replacement Policy implementation as tree pseudo-LRU
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "policy.h"
+
+// The ways of a set are the leaves of a binary tree whose inner nodes hold
+// one bit each, pointing at the half the next victim comes from; filling or
+// hitting a way turns the bits on its path away from it. That is ways - 1
+// bits per set and O(log ways) per update, as in the L1 TLBs and caches of
+// most cores. A set whose ways are not a power of 2 takes the tree of the
+// next one, a bit pointing at a half without ways being ignored.
+class ReplacementPolicyPlru : public ReplacementPolicy {
+   public:
+    ReplacementPolicyPlru(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicy{}, ways_{ways}, leaves_{leaves(ways)}, words_{(leaves_ + 63) / 64},
+          bits_(static_cast<size_t>(sets) * words_) {}
+    virtual ~ReplacementPolicyPlru() = default;
+
+    virtual auto fill(size_type set, size_type way) -> void override;
+    virtual auto victim(size_type set) -> size_type override;
+    virtual auto touch(size_type set, size_type way) -> void override;
+    virtual auto drop(size_type set, size_type way) -> void override;
+    virtual auto clear() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
+
+   private:
+    static auto leaves(size_type ways) -> size_type {
+        size_type n = 1;
+        while (n < ways) {
+            n *= 2;
+        }
+        return n;
+    }
+
+    auto point_away(size_type set, size_type way) -> void;
+
+   private:
+    const size_type ways_;
+    const size_type leaves_;
+    const size_type words_;  // per set
+    std::vector<uint64_t> bits_;  // node 1 is the root, node n has the children 2n and 2n + 1, a set bit points right
+
+   private:
+    ReplacementPolicyPlru(const ReplacementPolicyPlru&) = delete;
+    ReplacementPolicyPlru& operator=(const ReplacementPolicyPlru&) = delete;
+};
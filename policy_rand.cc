@@ -2,39 +2,32 @@
 // Replacement Policy by Random
 // Author: Hank Bao
 
-#include <cassert>
-#include <random>
-#include <utility>
-
 #include "policy_rand.h"
+#include "snapshot.h"
 
-auto ReplacementPolicyRand::replace(
-    std::map<size_type, TlbEntry>& cache, size_type cache_size, size_type vpn,
-    size_type pfn, bool valid) -> std::optional<std::pair<size_type, TlbEntry>> {
-    // save pfn in the cache
-    cache[vpn] = std::make_pair(pfn, valid);
-
-    // save vpn in the queue for bookkeeping
-    queue_.push_back(vpn);
+auto ReplacementPolicyRand::fill(size_type set, size_type way) -> void {
+    // nothing to remember, every way of a full set is equally likely to go
+}
 
-    // evict one item randomly if the cache is full
-    if (cache.size() > cache_size) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> distrib(0, cache_size - 1);
+auto ReplacementPolicyRand::victim(size_type set) -> size_type {
+    // evict one way randomly
+    return rng_.below(ways_);
+}
 
-        auto idx = distrib(gen);
-        auto victim = queue_.at(idx);
-        queue_.erase(queue_.begin() + idx);
+auto ReplacementPolicyRand::drop(size_type set, size_type way) -> void {
+    // the way is filled again before the set is full, so it cannot be drawn meanwhile
+}
 
-        auto it = cache.find(victim);
-        assert(it != cache.end());
+auto ReplacementPolicyRand::clear() -> void {
+    // the generator goes on, so a run is still repeated by its seed
+}
 
-        auto kv = *it;
-        cache.erase(it);
+auto ReplacementPolicyRand::save(SnapshotWriter& writer) const -> void {
+    writer.put<uint8_t>('R');
+    writer.put(rng_.state());
+}
 
-        return kv;
-    } else {
-        return std::nullopt;
-    }
+auto ReplacementPolicyRand::load(SnapshotReader& reader) -> void {
+    reader.expect<uint8_t>('R', "replacement policy");
+    rng_.set_state(reader.get<uint64_t>());
 }
@@ -4,21 +4,28 @@
 
 #pragma once
 
-#include <vector>
-
 #include "policy.h"
+#include "rng.h"
 
+// Victims are drawn from the policy's own generator, so a run is repeated
+// exactly by reusing its seed. Since a victim is only asked for once a set
+// is full, any way of the set is a candidate and no bookkeeping is needed.
 class ReplacementPolicyRand : public ReplacementPolicy {
    public:
-    ReplacementPolicyRand(size_type capacity) : ReplacementPolicy{}, queue_{} {}
+    ReplacementPolicyRand(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicy{}, ways_{ways}, rng_{seed} {}
     virtual ~ReplacementPolicyRand() = default;
 
-    virtual auto replace(
-        std::map<size_type, TlbEntry>& cache, size_type cache_size, size_type vpn,
-        size_type pfn, bool valid) -> std::optional<std::pair<size_type, TlbEntry>> override;
+    virtual auto fill(size_type set, size_type way) -> void override;
+    virtual auto victim(size_type set) -> size_type override;
+    virtual auto drop(size_type set, size_type way) -> void override;
+    virtual auto clear() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
 
    private:
-    std::vector<size_type> queue_;
+    const size_type ways_;
+    Rng rng_;
 
    private:
     ReplacementPolicyRand(const ReplacementPolicyRand&) = delete;
@@ -0,0 +1,91 @@
+// policy_rrip.cc
+// Replacement Policy by re-reference interval prediction
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cassert>
+
+#include "policy_rrip.h"
+#include "snapshot.h"
+
+auto ReplacementPolicyRrip::fill(size_type set, size_type way) -> void {
+    auto rrpv = kLongRrpv;
+    if (bimodal(set)) {
+        auto& fills = sets_[set].fills;
+        fills = fills + 1 == kBimodalPeriod ? 0 : fills + 1;
+        rrpv = fills == 0 ? kLongRrpv : kMaxRrpv;
+    }
+
+    lists_.push_front(set, way, list(set, rrpv));
+}
+
+auto ReplacementPolicyRrip::victim(size_type set) -> size_type {
+    auto& age = sets_[set].age;
+    auto distant = list(set, kMaxRrpv);
+    // age the set until some way is predicted distant, the list predicted 3 before is empty and becomes 0
+    while (lists_.empty(set, distant)) {
+        age = (age + 1) & kMaxRrpv;
+        distant = (distant - 1) & kMaxRrpv;
+    }
+
+    auto way = lists_.oldest(set, distant);
+    lists_.unlink(set, way);
+    return way;
+}
+
+auto ReplacementPolicyRrip::touch(size_type set, size_type way) -> void {
+    // hit priority, the entry is expected back soon
+    lists_.unlink(set, way);
+    lists_.push_front(set, way, list(set, 0));
+}
+
+auto ReplacementPolicyRrip::bimodal(size_type set) -> bool {
+    switch (insertion_) {
+        case RripInsertion::Static:
+            return false;
+
+        case RripInsertion::Bimodal:
+            return true;
+
+        case RripInsertion::Dynamic:
+            // every fill of a leader set is one of its misses
+            if (set % duel_period_ == 0) {
+                psel_ = std::min(psel_ + 1, kPselMax);
+                return false;
+            } else if (set % duel_period_ == duel_period_ - 1) {
+                psel_ = psel_ == 0 ? 0 : psel_ - 1;
+                return true;
+            }
+            return psel_ > kPselMax / 2;
+
+        default:
+            assert(false);
+            return false;
+    }
+}
+
+auto ReplacementPolicyRrip::drop(size_type set, size_type way) -> void {
+    lists_.unlink(set, way);
+}
+
+auto ReplacementPolicyRrip::clear() -> void {
+    // the selector keeps what the leader sets have taught it, a flush does not change the workload
+    lists_.clear();
+    std::fill(sets_.begin(), sets_.end(), Set{});
+}
+
+auto ReplacementPolicyRrip::save(SnapshotWriter& writer) const -> void {
+    const uint8_t tags[] = {'S', 'B', 'D'};
+    writer.put(tags[static_cast<int>(insertion_)]);
+    lists_.save(writer);
+    writer.put_vector(sets_);
+    writer.put(psel_);
+}
+
+auto ReplacementPolicyRrip::load(SnapshotReader& reader) -> void {
+    const uint8_t tags[] = {'S', 'B', 'D'};
+    reader.expect(tags[static_cast<int>(insertion_)], "replacement policy");
+    lists_.load(reader, "RRIP ways");
+    reader.get_vector(sets_, "RRIP sets");
+    psel_ = reader.get<uint32_t>();
+}
@@ -0,0 +1,95 @@
+// policy_rrip.h
+// Replacement Policy implementation as re-reference interval prediction
+// Author: Hank Bao
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "policy.h"
+#include "policy_lists.h"
+
+enum class RripInsertion {
+    Static,   // SRRIP, new entries predicted re-referenced in a long interval
+    Bimodal,  // BRRIP, in a distant one but for one fill in kBimodalPeriod
+    Dynamic,  // DRRIP, whichever of the two misses less in its leader sets
+};
+
+// RRIP (Jaleel et al., ISCA 2010) predicts for every way, in 2 bits, how
+// soon it is referenced again: 0 on a hit, 2 or 3 when filled depending on
+// the insertion. The victim is a way predicted 3, all predictions of the
+// set growing until one is. Since they all grow alike, the ways are kept
+// in one list per prediction and aging a set only turns its lists, so
+// every operation is O(1). The bimodal throttle counts the fills of each
+// set, leaving the sets independent of each other; the dynamic policy
+// duels with the first set of every kDuelPeriod for SRRIP and the last
+// one for BRRIP, a single set being an SRRIP leader.
+class ReplacementPolicyRrip : public ReplacementPolicy {
+   public:
+    virtual ~ReplacementPolicyRrip() = default;
+
+    virtual auto fill(size_type set, size_type way) -> void override;
+    virtual auto victim(size_type set) -> size_type override;
+    virtual auto touch(size_type set, size_type way) -> void override;
+    virtual auto drop(size_type set, size_type way) -> void override;
+    virtual auto clear() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
+
+   protected:
+    ReplacementPolicyRrip(size_type sets, size_type ways, RripInsertion insertion)
+        : ReplacementPolicy{},
+          insertion_{insertion},
+          duel_period_{std::min<size_type>(sets, kDuelPeriod)},
+          lists_{sets, ways, kMaxRrpv + 1},
+          sets_(sets),
+          psel_{kPselMax / 2} {}
+
+   private:
+    static constexpr size_type kMaxRrpv = 3;
+    static constexpr size_type kLongRrpv = kMaxRrpv - 1;
+    static constexpr uint8_t kBimodalPeriod = 32;
+    static constexpr size_type kDuelPeriod = 32;
+    static constexpr uint32_t kPselMax = 1023;  // a 10-bit policy selector, high when SRRIP misses more
+
+    struct Set {
+        uint8_t age = 0;    // added to the list of a way to get its prediction
+        uint8_t fills = 0;  // bimodal fills since the last long one
+    };
+
+    // the list holding the ways of the set predicted rrpv
+    auto list(size_type set, size_type rrpv) const -> size_type { return (rrpv - sets_[set].age) & kMaxRrpv; }
+    // whether a fill of the set inserts as BRRIP, training the selector on the leader sets
+    auto bimodal(size_type set) -> bool;
+
+   private:
+    const RripInsertion insertion_;
+    const size_type duel_period_;
+    WayLists lists_;
+    std::vector<Set> sets_;
+    uint32_t psel_;
+
+   private:
+    ReplacementPolicyRrip(const ReplacementPolicyRrip&) = delete;
+    ReplacementPolicyRrip& operator=(const ReplacementPolicyRrip&) = delete;
+};
+
+class ReplacementPolicySrrip : public ReplacementPolicyRrip {
+   public:
+    ReplacementPolicySrrip(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicyRrip{sets, ways, RripInsertion::Static} {}
+};
+
+class ReplacementPolicyBrrip : public ReplacementPolicyRrip {
+   public:
+    ReplacementPolicyBrrip(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicyRrip{sets, ways, RripInsertion::Bimodal} {}
+};
+
+class ReplacementPolicyDrrip : public ReplacementPolicyRrip {
+   public:
+    ReplacementPolicyDrrip(size_type sets, size_type ways, uint64_t seed)
+        : ReplacementPolicyRrip{sets, ways, RripInsertion::Dynamic} {}
+};
@@ -0,0 +1,164 @@
+// prefetcher.cc
+// Hardware TLB prefetchers and the buffer holding their translations
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "prefetcher.h"
+
+auto PrefetcherSequential::predict(page_type vpn, std::vector<page_type>& out) -> void {
+    for (size_type i = 1; i <= degree_; ++i) {
+        out.push_back(vpn + i);
+    }
+}
+
+PrefetcherStride::PrefetcherStride(size_type degree) : Prefetcher{}, degree_{degree}, streams_(kStreams), now_{0} {}
+
+auto PrefetcherStride::predict(page_type vpn, std::vector<page_type>& out) -> void {
+    now_ += 1;
+
+    // the stream this miss continues, else the one to replace
+    Stream* nearest = nullptr;
+    Stream* oldest = &streams_[0];
+    int64_t best = kWindow + 1;
+    for (auto& s : streams_) {
+        if (s.used != 0) {
+            int64_t delta = static_cast<int64_t>(vpn - s.last);
+            if (delta != 0 && std::llabs(delta) < best) {
+                best = std::llabs(delta);
+                nearest = &s;
+            }
+        }
+        if (s.used < oldest->used) {
+            oldest = &s;
+        }
+    }
+
+    if (nearest == nullptr) {
+        *oldest = Stream{vpn, 0, 0, now_};
+        return;
+    }
+
+    int64_t stride = static_cast<int64_t>(vpn - nearest->last);
+    if (stride == nearest->stride) {
+        nearest->confidence += 1;
+    } else {
+        nearest->stride = stride;
+        nearest->confidence = 0;
+    }
+    nearest->last = vpn;
+    nearest->used = now_;
+
+    if (nearest->confidence >= 1) {
+        for (size_type i = 1; i <= degree_; ++i) {
+            out.push_back(vpn + static_cast<page_type>(stride * i));
+        }
+    }
+}
+
+PrefetcherDistance::PrefetcherDistance() : Prefetcher{}, rows_(kRows), last_{}, distance_{} {}
+
+auto PrefetcherDistance::row(int64_t distance) -> Row& {
+    return rows_[static_cast<uint64_t>(distance) % kRows];
+}
+
+auto PrefetcherDistance::predict(page_type vpn, std::vector<page_type>& out) -> void {
+    if (!last_) {
+        last_ = vpn;
+        return;
+    }
+
+    int64_t distance = static_cast<int64_t>(vpn - *last_);
+    last_ = vpn;
+
+    // the previous distance was followed by this one
+    if (distance_) {
+        Row& prev = row(*distance_);
+        if (!prev.used || prev.distance != *distance_) {
+            prev = Row{*distance_, true, {}, 0};
+        }
+
+        bool known = false;
+        for (size_type i = 0; i < prev.count; ++i) {
+            known = known || prev.next[i] == distance;
+        }
+        if (!known) {
+            // the most recent distance first
+            for (size_type i = kSlots - 1; i > 0; --i) {
+                prev.next[i] = prev.next[i - 1];
+            }
+            prev.next[0] = distance;
+            prev.count = std::min(prev.count + 1, kSlots);
+        }
+    }
+    distance_ = distance;
+
+    const Row& current = row(distance);
+    if (current.used && current.distance == distance) {
+        for (size_type i = 0; i < current.count; ++i) {
+            out.push_back(vpn + static_cast<page_type>(current.next[i]));
+        }
+    }
+}
+
+auto PrefetchBuffer::contains(page_type vpn) const -> bool {
+    for (const auto& e : entries_) {
+        if (e.valid && e.vpn == vpn) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto PrefetchBuffer::take(page_type vpn) -> std::optional<Entry> {
+    for (auto& e : entries_) {
+        if (e.valid && e.vpn == vpn) {
+            e.valid = false;
+            return e;
+        }
+    }
+    return std::nullopt;
+}
+
+auto PrefetchBuffer::insert(page_type vpn, page_type pfn, uint64_t ready) -> bool {
+    if (entries_.empty()) {
+        return false;
+    }
+
+    Entry& e = entries_[head_];
+    bool pushed = e.valid;
+    e = Entry{vpn, pfn, ready, true};
+    head_ = (head_ + 1) % entries_.size();
+
+    return pushed;
+}
+
+auto PrefetchBuffer::invalidate(page_type vpn) -> void {
+    take(vpn);
+}
+
+auto PrefetchBuffer::flush() -> void {
+    for (auto& entry : entries_) {
+        entry.valid = false;
+    }
+}
+
+auto make_prefetcher(const PrefetchConfig& config) -> std::unique_ptr<Prefetcher> {
+    switch (config.kind) {
+        case PrefetchKind::None:
+            return nullptr;
+
+        case PrefetchKind::Sequential:
+            return std::make_unique<PrefetcherSequential>(config.degree);
+
+        case PrefetchKind::Stride:
+            return std::make_unique<PrefetcherStride>(config.degree);
+
+        case PrefetchKind::Distance:
+            return std::make_unique<PrefetcherDistance>();
+
+        default:
+            std::abort();
+    }
+}
@@ -0,0 +1,149 @@
+// prefetcher.h
+// Hardware TLB prefetchers and the buffer holding their translations
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "def.h"
+
+enum class PrefetchKind {
+    None,
+    Sequential,
+    Stride,
+    Distance,
+};
+
+struct PrefetchConfig {
+    PrefetchKind kind = PrefetchKind::None;
+    uint32_t degree = 1;    // pages predicted ahead by the sequential and stride prefetchers
+    uint32_t buffer = 16;   // entries of the prefetch buffer
+    uint32_t cost = 1;      // lookup in the prefetch buffer, probed after the TLBs miss
+};
+
+// how the prefetches of a run fared
+struct PrefetchStats {
+    uint64_t issued = 0;  // translations put in the buffer
+    uint64_t useful = 0;  // of those, hit by a demand miss
+    uint64_t late = 0;    // of the useful, hit before their walk had completed
+    uint64_t unused = 0;  // pushed out of the buffer without being hit
+};
+
+// Predicts the pages missed next from the pages missing the TLBs now.
+class Prefetcher {
+   public:
+    Prefetcher() = default;
+    virtual ~Prefetcher() = default;
+
+    // learn about a miss on the vpn, append the pages worth prefetching to out
+    virtual auto predict(page_type vpn, std::vector<page_type>& out) -> void = 0;
+
+   private:
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+};
+
+// the next degree pages after every miss
+class PrefetcherSequential : public Prefetcher {
+   public:
+    PrefetcherSequential(size_type degree) : Prefetcher{}, degree_{degree} {}
+    virtual ~PrefetcherSequential() = default;
+
+    virtual auto predict(page_type vpn, std::vector<page_type>& out) -> void override;
+
+   private:
+    const size_type degree_;
+};
+
+// Traces carry no PC, so strides are tracked per stream instead: a miss
+// belongs to the stream whose last miss is nearest, within kWindow pages,
+// and a stream seen twice with the same stride prefetches degree strides
+// ahead. The least recently extended stream makes room for a new one.
+class PrefetcherStride : public Prefetcher {
+   public:
+    PrefetcherStride(size_type degree);
+    virtual ~PrefetcherStride() = default;
+
+    virtual auto predict(page_type vpn, std::vector<page_type>& out) -> void override;
+
+   private:
+    static constexpr size_type kStreams = 16;
+    static constexpr int64_t kWindow = 64;
+
+    struct Stream {
+        page_type last = 0;
+        int64_t stride = 0;
+        uint32_t confidence = 0;
+        uint64_t used = 0;  // time of the last miss, 0 for a free stream
+    };
+
+    const size_type degree_;
+    std::vector<Stream> streams_;
+    uint64_t now_;
+};
+
+// Distance prefetching (Kandiraju and Sivasubramaniam): the distances
+// between consecutive misses are learnt as a table from one distance to the
+// two distances that last followed it, predicting pages at those distances.
+class PrefetcherDistance : public Prefetcher {
+   public:
+    PrefetcherDistance();
+    virtual ~PrefetcherDistance() = default;
+
+    virtual auto predict(page_type vpn, std::vector<page_type>& out) -> void override;
+
+   private:
+    static constexpr size_type kRows = 256;
+    static constexpr size_type kSlots = 2;
+
+    struct Row {
+        int64_t distance = 0;
+        bool used = false;
+        int64_t next[kSlots] = {};
+        size_type count = 0;
+    };
+
+    auto row(int64_t distance) -> Row&;
+
+    std::vector<Row> rows_;  // direct-mapped by distance
+    std::optional<page_type> last_;
+    std::optional<int64_t> distance_;
+};
+
+// A small fully associative FIFO of prefetched translations, each ready
+// once the walk fetching it would have completed.
+class PrefetchBuffer {
+   public:
+    struct Entry {
+        page_type vpn;
+        page_type pfn;
+        uint64_t ready;
+        bool valid;
+    };
+
+    PrefetchBuffer(size_type capacity) : entries_(capacity, Entry{0, 0, 0, false}), head_{0} {}
+    ~PrefetchBuffer() = default;
+
+    auto contains(page_type vpn) const -> bool;
+    // remove the entry of the vpn and return it, if buffered
+    auto take(page_type vpn) -> std::optional<Entry>;
+    // buffer a translation, returns true if it pushed out a valid one
+    auto insert(page_type vpn, page_type pfn, uint64_t ready) -> bool;
+    // drop the entry of the vpn, if buffered
+    auto invalidate(page_type vpn) -> void;
+    // drop every entry
+    auto flush() -> void;
+
+   private:
+    std::vector<Entry> entries_;
+    size_t head_;  // the oldest entry, replaced next
+
+    PrefetchBuffer(const PrefetchBuffer&) = delete;
+    PrefetchBuffer& operator=(const PrefetchBuffer&) = delete;
+};
+
+auto make_prefetcher(const PrefetchConfig& config) -> std::unique_ptr<Prefetcher>;
@@ -0,0 +1,49 @@
+// rng.h
+// Small, fast and seedable pseudo random number generator
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+
+// xorshift64* seeded through splitmix64, so nearby seeds still give
+// unrelated streams. Not for cryptography, only for reproducible runs.
+class Rng {
+   public:
+    explicit Rng(uint64_t seed) : state_{splitmix64(seed)} {
+        if (state_ == 0) {
+            // the only state xorshift never leaves
+            state_ = 0x9e3779b97f4a7c15ull;
+        }
+    }
+
+    auto next() -> uint64_t {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545f4914f6cdd1dull;
+    }
+
+    // uniform in [0, n), by multiply-shift instead of a division
+    auto below(uint32_t n) -> uint32_t {
+        return static_cast<uint32_t>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32);
+    }
+
+    // uniform in [0, 1)
+    auto uniform() -> double { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // the generator exactly as it is, to carry on later from the same point
+    auto state() const -> uint64_t { return state_; }
+    auto set_state(uint64_t state) -> void { state_ = state; }
+
+   private:
+    static auto splitmix64(uint64_t x) -> uint64_t {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+   private:
+    uint64_t state_;
+};
@@ -0,0 +1,200 @@
+// sample.cc
+// Sampled replay of one reference stream with confidence intervals
+// Author: Hank Bao
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#include "block_window.h"
+#include "rng.h"
+#include "sample.h"
+#include "shard.h"
+
+// two-sided 95% quantile of the normal distribution
+static constexpr double kZ95 = 1.96;
+
+auto sample_to_string(const SampleConfig& sample) -> std::string {
+    switch (sample.kind) {
+        case SampleKind::None:
+            return "none";
+        case SampleKind::Sets:
+            return "sets:" + std::to_string(sample.sampled) + ":" + std::to_string(sample.groups);
+        case SampleKind::Time:
+            return "time:" + std::to_string(sample.period) + ":" + std::to_string(sample.window) + ":" +
+                   std::to_string(sample.warmup);
+        default:
+            std::abort();
+    }
+}
+
+auto parse_sample(const std::string& str) -> SampleConfig {
+    auto fields = split_string(str, ":");
+    for (size_t i = 1; i < fields.size(); ++i) {
+        if (fields[i].empty()) {
+            std::fprintf(stderr, "Invalid sample: %s\n", str.c_str());
+            print_usage(true);
+        }
+    }
+
+    SampleConfig sample{};
+    if (fields[0] == "sets" && fields.size() == 3 && str_to_num(fields[1]) <= UINT32_MAX &&
+        str_to_num(fields[2]) <= UINT32_MAX) {
+        sample.kind = SampleKind::Sets;
+        sample.sampled = static_cast<uint32_t>(str_to_num(fields[1]));
+        sample.groups = static_cast<uint32_t>(str_to_num(fields[2]));
+    } else if (fields[0] == "time" && (fields.size() == 3 || fields.size() == 4)) {
+        sample.kind = SampleKind::Time;
+        sample.period = str_to_num(fields[1]);
+        sample.window = str_to_num(fields[2]);
+        sample.warmup = fields.size() == 4 ? str_to_num(fields[3]) : 0;
+    } else {
+        std::fprintf(stderr, "Invalid sample: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return sample;
+}
+
+auto validate_sample(const MmuConfig& config, const SampleConfig& sample) -> void {
+    if (sample.kind == SampleKind::Sets) {
+        validate_shards(config, sample.groups);
+        if (sample.sampled == 0 || sample.sampled > sample.groups) {
+            std::fprintf(stderr, "Invalid sample: %u of %u groups of sets\n", sample.sampled, sample.groups);
+            print_usage(true);
+        }
+    } else if (sample.kind == SampleKind::Time) {
+        if (sample.window == 0 || sample.warmup + sample.window > sample.period) {
+            std::fprintf(stderr, "Invalid sample: windows of %" PRIu64 " after %" PRIu64 " warm-up every %" PRIu64 "\n",
+                         sample.window, sample.warmup, sample.period);
+            print_usage(true);
+        }
+    }
+}
+
+auto run_sample(const MmuConfig& config, const SampleConfig& sample, const std::vector<addr_type>& prefetches,
+                const SweepSource& source) -> SampleResult {
+    SampleResult result{0, 0, {}};
+
+    const auto offset_bits = static_cast<size_type>(std::log2(config.page_size));
+    const page_type mask = sample.kind == SampleKind::Sets ? sample.groups - 1 : 0;
+    auto group_of = [&](addr_type vaddr) { return static_cast<size_t>(page_number(vaddr, offset_bits) & mask); };
+
+    // the unit measuring every group of sets, if sampled
+    std::vector<size_t> unit_of{};
+    if (sample.kind == SampleKind::Sets) {
+        std::vector<size_t> groups(sample.groups);
+        std::iota(groups.begin(), groups.end(), 0);
+        Rng rng{config.seed};
+        unit_of.assign(sample.groups, SIZE_MAX);
+        for (uint32_t i = 0; i < sample.sampled; ++i) {
+            std::swap(groups[i], groups[i + rng.below(sample.groups - i)]);
+            unit_of[groups[i]] = i;
+        }
+        result.units.assign(sample.sampled, SampleUnit{0, 0, 0});
+    }
+
+    auto mmu = make_mmu(config);
+    mmu->set_verbose(false);
+    for (const auto& addr : prefetches) {
+        if (sample.kind != SampleKind::Sets || unit_of[group_of(addr)] != SIZE_MAX) {
+            mmu->access(addr, true);
+        }
+    }
+
+    std::vector<addr_type> block(kBlockSize);
+    for (;;) {
+        size_t n = source(block.data(), kBlockSize);
+        if (n == 0) {
+            break;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            const auto addr = block[i];
+            if (is_context_switch(addr)) {
+                mmu->switch_context(switch_asid(addr));
+                continue;
+            } else if (is_unmap(addr)) {
+                mmu->invalidate(unmap_address(addr), mmu->asid());
+                continue;
+            }
+
+            SampleUnit* unit = nullptr;
+            bool simulated = true;
+            if (sample.kind == SampleKind::Sets) {
+                auto u = unit_of[group_of(addr)];
+                simulated = u != SIZE_MAX;
+                unit = simulated ? &result.units[u] : nullptr;
+            } else {
+                auto phase = result.accesses % sample.period;
+                simulated = phase < sample.warmup + sample.window;
+                if (phase == sample.warmup) {
+                    result.units.push_back(SampleUnit{0, 0, 0});
+                }
+                unit = simulated && phase >= sample.warmup ? &result.units.back() : nullptr;
+            }
+            result.accesses += 1;
+
+            if (!simulated) {
+                continue;
+            }
+
+            result.simulated += 1;
+            auto access = mmu->access(addr, false);
+            if (unit != nullptr) {
+                unit->accesses += 1;
+                unit->hits += access.first;
+                unit->cost += access.second;
+            }
+        }
+    }
+
+    return result;
+}
+
+// a ratio of totals over the units and the half-width of its confidence interval
+static auto estimate(const SampleResult& result, uint64_t SampleUnit::*value) -> std::pair<double, double> {
+    double total = 0;
+    double accesses = 0;
+    size_t n = 0;
+    for (const auto& unit : result.units) {
+        if (unit.accesses != 0) {
+            total += unit.*value;
+            accesses += unit.accesses;
+            n += 1;
+        }
+    }
+    if (accesses == 0) {
+        return std::make_pair(0.0, NAN);
+    }
+
+    double ratio = total / accesses;
+    if (n < 2) {
+        return std::make_pair(ratio, NAN);
+    }
+
+    // variance of a ratio estimator over clusters, with the finite population correction
+    double residuals = 0;
+    for (const auto& unit : result.units) {
+        if (unit.accesses != 0) {
+            double r = unit.*value - ratio * unit.accesses;
+            residuals += r * r;
+        }
+    }
+    double mean = accesses / n;
+    double covered = accesses / result.accesses;
+    double variance = (1 - covered) * residuals / (n - 1) / (n * mean * mean);
+
+    return std::make_pair(ratio, kZ95 * std::sqrt(std::max(variance, 0.0)));
+}
+
+auto print_sample_stats(const SampleResult& result) -> void {
+    auto [hitrate, hitrate_ci] = estimate(result, &SampleUnit::hits);
+    auto [cost, cost_ci] = estimate(result, &SampleUnit::cost);
+
+    std::printf("SAMPLESTATS units %zu, simulated %" PRIu64 " of %" PRIu64 " accesses (%.2f%%), hitrate %.4f +- %.4f"
+                ", average cost %.2f +- %.2fns (95%% confidence)\n",
+                result.units.size(), result.simulated, result.accesses,
+                result.accesses ? 100.0 * result.simulated / result.accesses : 0.0, hitrate, hitrate_ci, cost, cost_ci);
+}
@@ -0,0 +1,62 @@
+// sample.h
+// Sampled replay of one reference stream with confidence intervals
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "def.h"
+#include "hierarchy.h"
+#include "sweep.h"
+
+enum class SampleKind {
+    None,
+    Sets,  // a few groups of sets, simulated whole
+    Time,  // periodic windows of the stream, each after a warm-up
+};
+
+struct SampleConfig {
+    SampleKind kind = SampleKind::None;
+    uint32_t sampled = 0;  // groups of sets simulated
+    uint32_t groups = 0;   // groups the sets are split into, a power of 2
+    uint64_t period = 0;   // accesses from the start of a window to the next
+    uint64_t window = 0;   // accesses measured per window
+    uint64_t warmup = 0;   // accesses simulated but not measured before every window
+};
+
+// what one group of sets or one window measured
+struct SampleUnit {
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t cost;
+};
+
+struct SampleResult {
+    uint64_t accesses;   // of the whole stream
+    uint64_t simulated;  // through the MMU, warm-ups included
+    std::vector<SampleUnit> units;
+};
+
+// sets:SAMPLED:GROUPS or time:PERIOD:WINDOW[:WARMUP]
+auto sample_to_string(const SampleConfig& sample) -> std::string;
+auto parse_sample(const std::string& str) -> SampleConfig;
+
+// Exits with an error unless the sampling fits the configuration, sets
+// being grouped as shards are (see validate_shards).
+auto validate_sample(const MmuConfig& config, const SampleConfig& sample) -> void;
+
+// Sets: the sets are split into groups by the low VPN bits as for shards
+// and a few groups, picked at random from the seed, simulated in full; the
+// accesses of the others are skipped. Time: of every period of accesses,
+// the first warmup only warm the TLBs up and the next window are measured;
+// the rest are skipped. Context switches and unmaps always go through.
+auto run_sample(const MmuConfig& config, const SampleConfig& sample, const std::vector<addr_type>& prefetches,
+                const SweepSource& source) -> SampleResult;
+
+// The hit rate and average cost of the whole stream estimated from the
+// units as ratios, with 95% confidence intervals from the spread of the
+// units and the fraction of the stream they cover.
+auto print_sample_stats(const SampleResult& result) -> void;
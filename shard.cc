@@ -0,0 +1,147 @@
+// shard.cc
+// Replay of one reference stream split by TLB set across threads
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "block_window.h"
+#include "shard.h"
+
+auto validate_shards(const MmuConfig& config, size_t shards) -> void {
+    if (shards == 0 || (shards & (shards - 1)) != 0) {
+        std::fprintf(stderr, "Invalid shards: %zu, must be a power of 2\n", shards);
+        print_usage(true);
+    }
+
+    if (!config.regions.empty() || config.walk.levels != 0 || config.memory.frames != 0 ||
+        config.prefetch.kind != PrefetchKind::None) {
+        std::fprintf(stderr, "Cannot split into shards with regions, page walks, frames or prefetchers\n");
+        print_usage(true);
+    }
+
+    // the levels of the default page size
+    auto levels = config.levels;
+    for (const auto& page_tlb : config.page_tlbs) {
+        if (page_tlb.page_size == config.page_size) {
+            if (levels.empty()) {
+                levels.push_back(page_tlb.level);
+            } else {
+                levels[0] = page_tlb.level;
+            }
+        }
+    }
+
+    for (const auto& level : levels) {
+        if (level.size == 0) {
+            continue;
+        }
+
+        if (policy_ties_sets(level.policy)) {
+            std::fprintf(stderr, "Cannot split into shards with a policy common to all sets: %s\n",
+                         level_to_string(level).c_str());
+            print_usage(true);
+        }
+
+        size_t sets = level.ways == 0 ? 1 : level.size / level.ways;
+        if (shards > sets) {
+            std::fprintf(stderr, "Cannot split into %zu shards a level of %zu sets: %s\n", shards, sets,
+                         level_to_string(level).c_str());
+            print_usage(true);
+        }
+    }
+}
+
+auto run_shards(const MmuConfig& config, size_t shards, size_t threads,
+                const std::vector<addr_type>& prefetches, const SweepSource& source) -> ShardResult {
+    const auto offset_bits = static_cast<size_type>(std::log2(config.page_size));
+    const page_type mask = shards - 1;
+    auto shard_of = [&](addr_type vaddr) { return static_cast<size_t>(page_number(vaddr, offset_bits) & mask); };
+
+    std::vector<ShardResult> results(shards, ShardResult{0, 0, 0, ContextStats{}});
+
+    threads = std::clamp<size_t>(threads, 1, shards);
+    BlockWindow window{threads};
+
+    std::vector<std::thread> workers{};
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            std::vector<std::pair<size_t, std::unique_ptr<Mmu>>> mmus{};
+            for (size_t s = w; s < shards; s += threads) {
+                auto mmu = make_mmu(config);
+                mmu->set_verbose(false);
+                for (const auto& addr : prefetches) {
+                    if (shard_of(addr) == s) {
+                        mmu->access(addr, true);
+                    }
+                }
+                mmus.emplace_back(s, std::move(mmu));
+            }
+
+            for (size_t seq = 0;; ++seq) {
+                const auto* block = window.acquire(seq);
+                if (block == nullptr) {
+                    break;
+                }
+
+                for (auto& [s, mmu] : mmus) {
+                    auto& result = results[s];
+                    for (const auto& addr : *block) {
+                        if (is_context_switch(addr)) {
+                            // a flush empties the sets of every shard, but happens once
+                            auto cost = mmu->switch_context(switch_asid(addr));
+                            result.total_cost += s == 0 ? cost : 0;
+                            continue;
+                        } else if (is_unmap(addr)) {
+                            if (shard_of(unmap_address(addr)) == s) {
+                                mmu->invalidate(unmap_address(addr), mmu->asid());
+                            }
+                            continue;
+                        } else if (shard_of(addr) != s) {
+                            continue;
+                        }
+
+                        auto access = mmu->access(addr, false);
+                        if (access.first) {
+                            result.hits += 1;
+                        } else {
+                            result.misses += 1;
+                        }
+                        result.total_cost += access.second;
+                    }
+                }
+
+                window.release(w, seq);
+            }
+
+            for (auto& [s, mmu] : mmus) {
+                results[s].context = mmu->context_stats();
+            }
+        });
+    }
+
+    // decode the stream on this thread
+    window.produce(source);
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // switches and flushes are seen by every shard, reloads by one
+    ShardResult merged{0, 0, 0, results[0].context};
+    merged.context.reloads = 0;
+    merged.context.reload_cost = 0;
+    for (const auto& result : results) {
+        merged.hits += result.hits;
+        merged.misses += result.misses;
+        merged.total_cost += result.total_cost;
+        merged.context.reloads += result.context.reloads;
+        merged.context.reload_cost += result.context.reload_cost;
+    }
+
+    return merged;
+}
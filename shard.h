@@ -0,0 +1,37 @@
+// shard.h
+// Replay of one reference stream split by TLB set across threads
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "def.h"
+#include "hierarchy.h"
+#include "mmu.h"
+#include "sweep.h"
+
+struct ShardResult {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t total_cost;
+    ContextStats context;
+};
+
+// Exits with an error unless the configuration splits into shards, a power
+// of 2 no larger than the sets of any level: every set must keep to itself,
+// so no level may pick victims at random, and nothing beyond the TLBs (page
+// walks, frames, prefetchers, regions) may tie the pages together.
+auto validate_shards(const MmuConfig& config, size_t shards) -> void;
+
+// A VPN only ever meets the sets it maps to, so the pages whose VPNs agree
+// in their low log2(shards) bits go through the same sets of every level
+// and nothing else. Every shard replays its own pages through an MMU of
+// its own, giving exactly the hits, misses and costs of a single MMU. The
+// stream is decoded once, every shard picking its pages out of the shared
+// blocks; context switches reach every shard, only the first being charged
+// for them, and unmaps the shard of their page. Shards are dealt
+// round-robin to the threads.
+auto run_shards(const MmuConfig& config, size_t shards, size_t threads,
+                const std::vector<addr_type>& prefetches, const SweepSource& source) -> ShardResult;
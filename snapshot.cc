@@ -0,0 +1,71 @@
+// snapshot.cc
+// Checkpoints of the state of the TLBs and their policies
+// Author: Hank Bao
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "mmu.h"
+#include "snapshot.h"
+#include "utils.h"
+
+// "TLBSNAP" and a format version
+static constexpr uint64_t kMagic = 0x0250414e53424c54ull;
+
+auto SnapshotReader::mismatch(const char* what) const -> void {
+    std::fprintf(stderr, "Snapshot %s does not match the configuration: %s\n", path_.c_str(), what);
+    ::exit(EXIT_FAILURE);
+}
+
+auto SnapshotReader::take(void* data, size_t size) -> void {
+    if (data_.size() - pos_ < size) {
+        std::fprintf(stderr, "Snapshot %s is truncated\n", path_.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+    std::memcpy(data, data_.data() + pos_, size);
+    pos_ += size;
+}
+
+Snapshot::Snapshot(const std::string& path) : path_{path}, data_{}, position_{0}, state_{0} {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        std::fprintf(stderr, "Cannot open snapshot: %s\n", path.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+    data_.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+
+    SnapshotReader reader{path_, data_, 0};
+    if (data_.size() < sizeof(kMagic) || reader.get<uint64_t>() != kMagic) {
+        std::fprintf(stderr, "Not a snapshot: %s\n", path.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+    position_ = reader.get<uint64_t>();
+    state_ = 2 * sizeof(uint64_t);
+}
+
+auto Snapshot::restore(Mmu& mmu) const -> void {
+    SnapshotReader reader{path_, data_, state_};
+    mmu.load(reader);
+}
+
+auto save_snapshot(const std::string& path, const Mmu& mmu, uint64_t position) -> void {
+    SnapshotWriter writer{path};
+    writer.put(kMagic);
+    writer.put(position);
+    mmu.save(writer);
+    writer.flush();
+}
+
+auto parse_checkpoint(const std::string& str, uint64_t& position, std::string& path) -> void {
+    auto colon = str.find(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == str.size()) {
+        std::fprintf(stderr, "Invalid checkpoint: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    position = str_to_num(str.substr(0, colon));
+    path = str.substr(colon + 1);
+}
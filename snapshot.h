@@ -0,0 +1,125 @@
+// snapshot.h
+// Checkpoints of the state of the TLBs and their policies
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "buffered_writer.h"
+#include "def.h"
+
+class Mmu;
+
+// Writes the state of an MMU as a flat sequence of fields in native byte
+// order, vectors prefixed by their length. No layout is described, the
+// reader has to ask for the same fields in the same order.
+class SnapshotWriter {
+   public:
+    explicit SnapshotWriter(const std::string& path) : writer_{path} {}
+    ~SnapshotWriter() = default;
+
+    template <typename T>
+    auto put(const T& value) -> void {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain fields are written as is");
+        writer_.write(&value, sizeof(T));
+    }
+
+    template <typename T>
+    auto put_vector(const std::vector<T>& values) -> void {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain fields are written as is");
+        put<uint64_t>(values.size());
+        writer_.write(values.data(), values.size() * sizeof(T));
+    }
+
+    auto flush() -> void { writer_.flush(); }
+
+   private:
+    BufferedWriter writer_;
+
+   private:
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+};
+
+// Reads the fields back from a snapshot in memory. Whatever does not fit
+// the MMU being restored, a level of another size or policy above all,
+// exits with an error naming it.
+class SnapshotReader {
+   public:
+    SnapshotReader(const std::string& path, const std::vector<char>& data, size_t pos)
+        : path_{path}, data_{data}, pos_{pos} {}
+    ~SnapshotReader() = default;
+
+    template <typename T>
+    auto get() -> T {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain fields are read as is");
+        T value;
+        take(&value, sizeof(T));
+        return value;
+    }
+
+    // the next field must be value
+    template <typename T>
+    auto expect(const T& value, const char* what) -> void {
+        if (get<T>() != value) {
+            mismatch(what);
+        }
+    }
+
+    // a vector of exactly as many values as values already holds
+    template <typename T>
+    auto get_vector(std::vector<T>& values, const char* what) -> void {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain fields are read as is");
+        if (get<uint64_t>() != values.size()) {
+            mismatch(what);
+        }
+        take(values.data(), values.size() * sizeof(T));
+    }
+
+    [[noreturn]] auto mismatch(const char* what) const -> void;
+
+   private:
+    auto take(void* data, size_t size) -> void;
+
+   private:
+    const std::string& path_;
+    const std::vector<char>& data_;
+    size_t pos_;
+
+   private:
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+};
+
+// A snapshot loaded once and restored into any number of MMUs, from as
+// many threads as needed.
+class Snapshot {
+   public:
+    explicit Snapshot(const std::string& path);
+    ~Snapshot() = default;
+
+    // records of the reference stream consumed when it was taken
+    auto position() const -> uint64_t { return position_; }
+    auto restore(Mmu& mmu) const -> void;
+
+   private:
+    const std::string path_;
+    std::vector<char> data_;
+    uint64_t position_;
+    size_t state_;  // where the state of the MMU starts
+
+   private:
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+};
+
+// the TLBs, policies, page-walk caches and address space of the MMU, position records into the stream
+auto save_snapshot(const std::string& path, const Mmu& mmu, uint64_t position) -> void;
+
+// ACCESSES:FILE
+auto parse_checkpoint(const std::string& str, uint64_t& position, std::string& path) -> void;
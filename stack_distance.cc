@@ -0,0 +1,172 @@
+// stack_distance.cc
+// Single-pass LRU stack distance analysis of a reference stream
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+#include "buffered_writer.h"
+#include "mmu.h"
+#include "stack_distance.h"
+
+// access times covered by the tree before the first renumbering
+static constexpr uint64_t kInitialSpan = 1 << 16;
+
+StackDistance::StackDistance(size_type page_size)
+    : offset_bits_{static_cast<size_type>(std::log2(page_size))},
+      asid_{0},
+      last_{},
+      tree_(kInitialSpan + 1, 0),
+      now_{0},
+      accesses_{0},
+      compulsory_{0},
+      histogram_{} {}
+
+auto StackDistance::access(addr_type vaddr, bool prefetching) -> void {
+    reference(tag_page(page_number(vaddr, offset_bits_), asid_), !prefetching);
+}
+
+auto StackDistance::reference(page_type vpn, bool counted) -> uint64_t {
+    if (now_ + 1 >= tree_.size()) {
+        compact();
+    }
+
+    auto [it, inserted] = last_.try_emplace(vpn, now_);
+    // pages touched after the previous access of this one
+    uint64_t distance = inserted ? kCold : last_.size() - prefix(it->second);
+
+    if (counted) {
+        accesses_ += 1;
+        if (inserted) {
+            compulsory_ += 1;
+        } else {
+            if (distance >= histogram_.size()) {
+                histogram_.resize(distance + 1, 0);
+            }
+            histogram_[distance] += 1;
+        }
+    }
+
+    if (!inserted) {
+        add(it->second, -1);
+        it->second = now_;
+    }
+    add(now_, 1);
+    now_ += 1;
+
+    return distance;
+}
+
+auto StackDistance::misses(uint64_t tlb_size) const -> uint64_t {
+    uint64_t misses = compulsory_;
+    for (uint64_t d = tlb_size; d < histogram_.size(); ++d) {
+        misses += histogram_[d];
+    }
+
+    return misses;
+}
+
+// the tree is 1-based, position p lives at index p + 1
+auto StackDistance::add(uint64_t pos, int32_t delta) -> void {
+    for (uint64_t i = pos + 1; i < tree_.size(); i += i & (~i + 1)) {
+        tree_[i] += delta;
+    }
+}
+
+// number of live access times in [0, pos]
+auto StackDistance::prefix(uint64_t pos) const -> uint64_t {
+    int64_t sum = 0;
+    for (uint64_t i = pos + 1; i > 0; i -= i & (~i + 1)) {
+        sum += tree_[i];
+    }
+
+    return static_cast<uint64_t>(sum);
+}
+
+auto StackDistance::compact() -> void {
+    // renumber the latest access of every page as 0, 1, 2, ... keeping their order
+    std::vector<std::pair<uint64_t, page_type>> order{};
+    order.reserve(last_.size());
+    for (const auto& [vpn, time] : last_) {
+        order.emplace_back(time, vpn);
+    }
+    std::sort(order.begin(), order.end());
+
+    uint64_t span = std::max<uint64_t>(kInitialSpan, 2 * order.size());
+    tree_.assign(span + 1, 0);
+
+    for (uint64_t i = 0; i < order.size(); ++i) {
+        last_[order[i].second] = i;
+        tree_[i + 1] = 1;
+    }
+
+    // linear-time construction: each node forwards its sum to its parent
+    for (uint64_t i = 1; i <= span; ++i) {
+        uint64_t parent = i + (i & (~i + 1));
+        if (parent <= span) {
+            tree_[parent] += tree_[i];
+        }
+    }
+
+    now_ = order.size();
+}
+
+// 1, 2, 3, 4, 6, 8, 12, 16, ...
+static auto next_curve_size(uint64_t size) -> uint64_t {
+    uint64_t power = uint64_t{1} << (63 - __builtin_clzll(size));
+    return size == power && size >= 2 ? size + power / 2 : power * 2;
+}
+
+auto print_miss_ratio_curve(const StackDistance& sd, time_type tlb_cost, time_type pagetable_cost) -> void {
+    uint64_t accesses = sd.accesses();
+
+    std::printf("MRC accesses %" PRIu64 ", pages %" PRIu64 ", compulsory misses %" PRIu64 "\n",
+                accesses, sd.pages(), sd.compulsory());
+    std::printf("%10s %14s %14s %9s %9s\n", "tlb_size", "hits", "misses", "missrate", "avg_cost");
+
+    // powers of 2 and the midpoints between them, till every page fits
+    for (uint64_t size = 1;; size = next_curve_size(size)) {
+        uint64_t misses = sd.misses(size);
+        uint64_t hits = accesses - misses;
+        std::printf("%10" PRIu64 " %14" PRIu64 " %14" PRIu64 " %9.4f %9.2f\n", size, hits, misses,
+                    accesses ? misses / (double)accesses : 0.0,
+                    accesses ? (hits * (double)tlb_cost + misses * (double)pagetable_cost) / accesses : 0.0);
+
+        if (size >= sd.pages()) {
+            break;
+        }
+    }
+}
+
+auto write_miss_ratio_curve(const StackDistance& sd, const std::string& path) -> void {
+    const auto& histogram = sd.histogram();
+    uint64_t accesses = sd.accesses();
+
+    // misses at each size, from the largest distance down
+    std::vector<uint64_t> misses(histogram.size() + 1);
+    misses[histogram.size()] = sd.compulsory();
+    for (size_t d = histogram.size(); d-- > 0;) {
+        misses[d] = misses[d + 1] + histogram[d];
+    }
+
+    BufferedWriter writer{path};
+    writer.put_str("tlb_size,misses,miss_ratio\n");
+
+    char ratio[32];
+    for (size_t size = 1; size <= histogram.size(); ++size) {
+        if (histogram[size - 1] == 0) {
+            continue;
+        }
+
+        std::snprintf(ratio, sizeof(ratio), "%.6f", accesses ? misses[size] / (double)accesses : 0.0);
+        writer.put_uint(size);
+        writer.put_char(',');
+        writer.put_uint(misses[size]);
+        writer.put_char(',');
+        writer.put_str(ratio);
+        writer.put_char('\n');
+    }
+}
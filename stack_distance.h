@@ -0,0 +1,68 @@
+// stack_distance.h
+// Single-pass LRU stack distance analysis of a reference stream
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "def.h"
+
+// Mattson's stack algorithm: an access hits in a fully associative LRU TLB
+// of n entries iff fewer than n other pages were touched since the last
+// access to its page. Counting those pages with a Fenwick tree over access
+// times gives the hit count of every TLB size in one pass, O(log n) per
+// reference. The tree only covers the latest access of each page and is
+// renumbered when it fills up, so memory follows the number of pages, not
+// the length of the stream.
+class StackDistance {
+   public:
+    // the distance of the first reference to a page
+    static constexpr uint64_t kCold = UINT64_MAX;
+
+    StackDistance(size_type page_size);
+    ~StackDistance() = default;
+
+    // prefetches warm the stack without being counted
+    auto access(addr_type vaddr, bool prefetching) -> void;
+    // the same for a page number as is, returns its stack distance or kCold
+    auto reference(page_type vpn, bool counted) -> uint64_t;
+    // the pages of every address space are told apart, as by a TLB tagged with ASIDs
+    auto switch_context(asid_type asid) -> void { asid_ = asid; }
+
+    auto accesses() const -> uint64_t { return accesses_; }
+    auto pages() const -> uint64_t { return last_.size(); }
+    // misses of a fully associative LRU TLB of the size
+    auto misses(uint64_t tlb_size) const -> uint64_t;
+    // the counted accesses by stack distance, compulsory misses excluded
+    auto histogram() const -> const std::vector<uint64_t>& { return histogram_; }
+    auto compulsory() const -> uint64_t { return compulsory_; }
+
+   private:
+    auto add(uint64_t pos, int32_t delta) -> void;
+    auto prefix(uint64_t pos) const -> uint64_t;
+    auto compact() -> void;
+
+   private:
+    const size_type offset_bits_;
+    asid_type asid_;
+    std::unordered_map<page_type, uint64_t> last_;
+    std::vector<int32_t> tree_;
+    uint64_t now_;
+    uint64_t accesses_;
+    uint64_t compulsory_;
+    std::vector<uint64_t> histogram_;
+
+   private:
+    StackDistance(const StackDistance&) = delete;
+    StackDistance& operator=(const StackDistance&) = delete;
+};
+
+// miss ratio and average cost of a single-level TLB at 1, 2, 3, 4, 6, 8, 12, ... entries
+auto print_miss_ratio_curve(const StackDistance& sd, time_type tlb_cost, time_type pagetable_cost) -> void;
+
+// tlb_size,misses,miss_ratio at every size where the curve steps down, as CSV
+auto write_miss_ratio_curve(const StackDistance& sd, const std::string& path) -> void;
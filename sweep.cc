@@ -0,0 +1,200 @@
+// sweep.cc
+// Replay of one reference stream through a grid of MMU configurations
+// Author: Hank Bao
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+
+#include "block_window.h"
+#include "snapshot.h"
+#include "sweep.h"
+
+static auto apply_sweep_value(MmuConfig& config, const std::string& key, const std::string& value) -> bool {
+    if (key == "size") {
+        config.page_size = parse_page_size(value);
+        return true;
+    } else if (key == "costpt") {
+        config.pagetable_cost = parse_cost(value);
+        return true;
+    } else if (key == "seed") {
+        config.seed = parse_seed(value);
+        return true;
+    } else if (key == "asid") {
+        parse_asid(value, config.asid);
+        return true;
+    }
+
+    // per-level keys, a trailing number picks the level, tlb2 is the second one
+    size_t digits = key.find_first_of("0123456789");
+    std::string name = key.substr(0, digits);
+    size_t n = digits == std::string::npos ? 1 : std::strtoul(key.c_str() + digits, nullptr, 10);
+    if (n == 0 || (digits != std::string::npos && key.find_first_not_of("0123456789", digits) != std::string::npos)) {
+        return false;
+    }
+    if (n > config.levels.size()) {
+        std::fprintf(stderr, "No level %zu to sweep: %s\n", n, key.c_str());
+        print_usage(true);
+    }
+
+    LevelConfig& level = config.levels[n - 1];
+    if (name == "tlb") {
+        level.size = parse_tlb_size(value);
+    } else if (name == "ways") {
+        level.ways = parse_ways(value);
+    } else if (name == "cost") {
+        level.cost = parse_cost(value);
+    } else if (name == "policy") {
+        level.policy = parse_policy(value);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+auto expand_sweep_grid(const MmuConfig& base, const std::string& grid) -> std::vector<MmuConfig> {
+    std::vector<MmuConfig> configs{base};
+
+    for (const auto& axis : split_string(grid, ";")) {
+        if (axis.empty()) {
+            continue;
+        }
+
+        auto kv = split_string(axis, "=");
+        if (kv.size() != 2 || kv[1].empty()) {
+            std::fprintf(stderr, "Invalid sweep axis: %s\n", axis.c_str());
+            print_usage(true);
+        }
+
+        // the last axis varies fastest
+        std::vector<MmuConfig> expanded{};
+        for (const auto& config : configs) {
+            for (const auto& value : split_string(kv[1], ",")) {
+                MmuConfig next = config;
+                if (!apply_sweep_value(next, kv[0], value)) {
+                    std::fprintf(stderr, "Invalid sweep key: %s\n", kv[0].c_str());
+                    print_usage(true);
+                }
+                expanded.push_back(std::move(next));
+            }
+        }
+        configs = std::move(expanded);
+    }
+
+    // sizes may have changed under fixed ways
+    for (auto& config : configs) {
+        for (auto& level : config.levels) {
+            level.ways = resolve_ways(level.size, level.ways, 0);
+        }
+    }
+
+    return configs;
+}
+
+auto run_sweep(const std::vector<MmuConfig>& configs, size_t threads, const std::vector<addr_type>& prefetches,
+               const SweepSource& source, const Snapshot* snapshot) -> std::vector<SweepResult> {
+    std::vector<SweepResult> results(configs.size(), SweepResult{0, 0, 0});
+    if (configs.empty()) {
+        return results;
+    }
+
+    threads = std::clamp<size_t>(threads, 1, configs.size());
+    BlockWindow window{threads};
+
+    std::vector<std::thread> workers{};
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            // configurations are dealt round-robin to the workers
+            std::vector<std::pair<size_t, std::unique_ptr<Mmu>>> mmus{};
+            std::vector<SweepResult> mine{};
+            for (size_t i = w; i < configs.size(); i += threads) {
+                auto mmu = make_mmu(configs[i]);
+                mmu->set_verbose(false);
+                // a snapshot already holds what the prefetches left
+                if (snapshot) {
+                    snapshot->restore(*mmu);
+                } else {
+                    for (const auto& addr : prefetches) {
+                        mmu->access(addr, true);
+                    }
+                }
+
+                mmus.emplace_back(i, std::move(mmu));
+                mine.push_back(SweepResult{0, 0, 0});
+            }
+
+            for (size_t seq = 0;; ++seq) {
+                const auto* block = window.acquire(seq);
+                if (block == nullptr) {
+                    break;
+                }
+
+                for (size_t k = 0; k < mmus.size(); ++k) {
+                    auto& mmu = *mmus[k].second;
+                    auto& result = mine[k];
+                    for (const auto& addr : *block) {
+                        if (is_context_switch(addr)) {
+                            result.total_cost += mmu.switch_context(switch_asid(addr));
+                            continue;
+                        } else if (is_unmap(addr)) {
+                            mmu.invalidate(unmap_address(addr), mmu.asid());
+                            continue;
+                        }
+
+                        auto access = mmu.access(addr, false);
+                        if (access.first) {
+                            result.hits += 1;
+                        } else {
+                            result.misses += 1;
+                        }
+                        result.total_cost += access.second;
+                    }
+                }
+
+                window.release(w, seq);
+            }
+
+            for (size_t k = 0; k < mmus.size(); ++k) {
+                results[mmus[k].first] = mine[k];
+            }
+        });
+    }
+
+    // decode the stream on this thread
+    window.produce(source);
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return results;
+}
+
+auto print_sweep_table(const std::vector<MmuConfig>& configs, const std::vector<SweepResult>& results) -> void {
+    size_t levels = configs.empty() ? 0 : configs[0].levels.size();
+
+    std::printf("%-9s %-8s %-6s %-11s", "page_size", "pt_cost", "seed", "asid");
+    for (size_t i = 0; i < levels; ++i) {
+        std::printf(" L%-21zu", i + 1);
+    }
+    std::printf(" %12s %12s %7s %14s %8s\n", "hits", "misses", "hitrate", "total_cost", "avg_cost");
+
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const auto& config = configs[i];
+        const auto& result = results[i];
+        uint64_t accesses = result.hits + result.misses;
+
+        std::printf("%-9u %-8u %-6" PRIu64 " %-11s", config.page_size, config.pagetable_cost, config.seed,
+                    asid_to_string(config.asid).c_str());
+        for (const auto& level : config.levels) {
+            std::printf(" %-22s", level_to_string(level).c_str());
+        }
+        std::printf(" %12" PRIu64 " %12" PRIu64 " %7.4f %14" PRIu64 " %8.2f\n",
+                    result.hits, result.misses, accesses ? result.hits / (double)accesses : 0.0,
+                    result.total_cost, accesses ? result.total_cost / (double)accesses : 0.0);
+    }
+}
@@ -0,0 +1,37 @@
+// sweep.h
+// Replay of one reference stream through a grid of MMU configurations
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "def.h"
+#include "hierarchy.h"
+
+class Snapshot;
+
+struct SweepResult {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t total_cost;
+};
+
+// fills up to max addresses into the buffer and returns how many, 0 once the stream is over
+typedef std::function<size_t(addr_type* buffer, size_t max)> SweepSource;
+
+// every combination of the values in grid applied on top of base, the grid
+// being KEY=VALUE[,VALUE]...[;KEY=...] with the long option names as keys
+auto expand_sweep_grid(const MmuConfig& base, const std::string& grid) -> std::vector<MmuConfig>;
+
+// The stream is decoded once, in blocks shared read-only by a pool of
+// threads, each simulating its own share of the configurations. Only a few
+// blocks are alive at any time, so memory does not grow with the stream.
+// Given a snapshot, every MMU starts from its state, before the prefetches.
+auto run_sweep(const std::vector<MmuConfig>& configs, size_t threads, const std::vector<addr_type>& prefetches,
+               const SweepSource& source, const Snapshot* snapshot = nullptr) -> std::vector<SweepResult>;
+
+auto print_sweep_table(const std::vector<MmuConfig>& configs, const std::vector<SweepResult>& results) -> void;
@@ -0,0 +1,56 @@
+// tag_match.h
+// Parallel comparison of a TLB set's tags against one VPN
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "def.h"
+
+// number of tags compared by one vector instruction, the tag array of a set
+// must be readable that far past its end
+#if defined(__AVX2__)
+constexpr size_type kTagLanes = 8;
+#elif defined(__SSE2__)
+constexpr size_type kTagLanes = 4;
+#else
+constexpr size_type kTagLanes = 1;
+#endif
+
+// the widest set compared by scanning, wider ones are looked up by hashing
+constexpr size_type kMaxScanWays = 64;
+
+// bitmask of the ways among the first n (at most kMaxScanWays) whose tag equals vpn
+inline auto match_tags(const size_type* tags, size_type n, size_type vpn) -> uint64_t {
+    static_assert(sizeof(size_type) == 4, "tags are compared as 32-bit lanes");
+
+    uint64_t mask = 0;
+
+#if defined(__AVX2__)
+    const __m256i key = _mm256_set1_epi32(static_cast<int>(vpn));
+    for (size_type i = 0; i < n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i));
+        auto bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, key)));
+        mask |= static_cast<uint64_t>(bits) << i;
+    }
+#elif defined(__SSE2__)
+    const __m128i key = _mm_set1_epi32(static_cast<int>(vpn));
+    for (size_type i = 0; i < n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i));
+        auto bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, key)));
+        mask |= static_cast<uint64_t>(bits) << i;
+    }
+#else
+    for (size_type i = 0; i < n; ++i) {
+        mask |= static_cast<uint64_t>(tags[i] == vpn) << i;
+    }
+#endif
+
+    // drop the lanes read past the filled ways
+    return n >= 64 ? mask : mask & ((uint64_t{1} << n) - 1);
+}
@@ -6,16 +6,34 @@
 
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "def.h"
 
+struct LevelStats;
+class SnapshotReader;
+class SnapshotWriter;
+
 class Tlb {
    public:
     Tlb() = default;
     virtual ~Tlb() = default;
 
-    virtual auto lookup(size_type vpn) -> std::optional<std::pair<size_type, time_type>> = 0;
-    virtual auto insert(size_type vpn, size_type pfn, bool valid) -> void = 0;
+    virtual auto lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> = 0;
+    virtual auto insert(page_type vpn, page_type pfn, bool valid) -> void = 0;
+    // whether any level holds a valid translation of the vpn, without the policies learning about it
+    virtual auto probe(page_type vpn) const -> bool = 0;
+    // drop the translation of the vpn from every level
+    virtual auto invalidate(page_type vpn) -> void = 0;
+    // drop every translation from every level, appending the vpns of the valid ones to flushed
+    virtual auto flush(std::vector<page_type>& flushed) -> void = 0;
+    // append the counters of every level, top down, see LevelCounters
+    virtual auto level_stats(std::vector<LevelStats>& stats) const -> void = 0;
+    // classify the misses of every level from now on
+    virtual auto classify_misses() -> void = 0;
+    // write out and read back the entries and policies of every level, see Snapshot
+    virtual auto save(SnapshotWriter& writer) const -> void = 0;
+    virtual auto load(SnapshotReader& reader) -> void = 0;
 
    private:
     Tlb(const Tlb&) = delete;
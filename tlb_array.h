@@ -0,0 +1,268 @@
+// tlb_array.h
+// Entry storage of one TLB level, without any dispatch
+// Author: Hank Bao
+
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include "def.h"
+#include "policy.h"
+#include "snapshot.h"
+#include "tag_match.h"
+#include "tlb_index.h"
+
+// an entry pushed out of a level
+struct TlbEvictee {
+    page_type vpn;
+    TlbEntry entry;
+};
+
+// Entries live in a flat table of sets * ways slots allocated up front, set
+// by set. A VPN can only be cached in set (vpn % sets); the tags of a set,
+// 32-bit folds of the VPNs so a vector compares as many as possible, are
+// compared all at once and a match confirmed against the full VPN, or the
+// set is searched through the index when it is too wide to scan. Ways freed
+// by invalidation are filled first, and the policy RP picks the way to reuse
+// once a set is full, so nothing is allocated after construction. Passing 0
+// ways makes the array fully associative; the seed feeds the policy's
+// randomness, if any.
+//
+// Everything is defined here so the levels of a TlbChain inline it.
+template <typename RP>
+class TlbArray : private RP {
+   public:
+    TlbArray(const size_type capacity, const size_type ways, const uint64_t seed)
+        : RP{ways == 0 ? 1 : capacity / ways, ways == 0 ? capacity : ways, seed},
+          capacity_{capacity},
+          ways_{ways == 0 ? capacity : ways},
+          set_mask_{ways == 0 ? 0 : capacity / ways - 1},
+          indexed_{ways_ > kMaxScanWays},
+          sizes_(set_mask_ + 1),
+          frees_(set_mask_ + 1),
+          free_(capacity),
+          tags_(capacity + kTagLanes),
+          vpns_(capacity),
+          entries_(capacity),
+          index_{indexed_ ? capacity : 0} {}
+    ~TlbArray() = default;
+
+    auto capacity() const -> size_type { return capacity_; }
+
+    // the valid cached entry of the vpn, the policy learns about the hit
+    auto lookup(page_type vpn) -> const TlbEntry* {
+        const auto slot = find(vpn);
+        if (slot == TlbIndex::kNone || !entries_[slot].second) {
+            return nullptr;
+        }
+
+        const auto set = static_cast<size_type>(vpn & set_mask_);
+        RP::touch(set, slot - set * ways_);
+        return &entries_[slot];
+    }
+
+    // cache the entry, returns the one it replaced if the set was full
+    auto insert(page_type vpn, page_type pfn, bool valid) -> std::optional<TlbEvictee> {
+        if (capacity_ == 0) {
+            // a disabled level passes everything through
+            return TlbEvictee{vpn, TlbEntry{pfn, valid}};
+        }
+
+        const auto set = static_cast<size_type>(vpn & set_mask_);
+        auto slot = find(vpn);
+        if (slot != TlbIndex::kNone) {
+            // already cached, refresh the entry in place, taking back its way if it was invalidated
+            if (!entries_[slot].second && take_free(set, slot - set * ways_)) {
+                RP::fill(set, slot - set * ways_);
+            }
+            entries_[slot] = TlbEntry{pfn, valid};
+            return std::nullopt;
+        }
+
+        size_type way;
+        bool evicting = false;
+        bool replacing = true;
+        if (frees_[set] > 0) {
+            // an invalidated way is reused before any valid entry is evicted
+            way = free_[set * ways_ + --frees_[set]];
+        } else if (sizes_[set] < ways_) {
+            way = sizes_[set]++;
+            replacing = false;
+        } else {
+            way = RP::victim(set);
+            evicting = true;
+        }
+
+        slot = set * ways_ + way;
+        TlbEvictee evictee{vpns_[slot], entries_[slot]};
+
+        // save pfn in the cache
+        tags_[slot] = fold(vpn);
+        vpns_[slot] = vpn;
+        entries_[slot] = TlbEntry{pfn, valid};
+        if (indexed_) {
+            if (replacing) {
+                index_.erase(evictee.vpn);
+            }
+            index_.insert(vpn, slot);
+        }
+        RP::fill(set, way);
+
+        if (evicting) {
+            return evictee;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    // whether the vpn is cached and valid, the policy is not told
+    auto probe(page_type vpn) const -> bool {
+        const auto slot = find(vpn);
+        return slot != TlbIndex::kNone && entries_[slot].second;
+    }
+
+    // stop the entry of the vpn, if cached, from hitting and free its way
+    auto invalidate(page_type vpn) -> void {
+        const auto slot = find(vpn);
+        if (slot != TlbIndex::kNone && entries_[slot].second) {
+            entries_[slot].second = false;
+
+            // the way is free for the next fill of its set
+            const auto set = slot / ways_;
+            free_[set * ways_ + frees_[set]++] = slot - set * ways_;
+            RP::drop(set, slot - set * ways_);
+        }
+    }
+
+    // empty every set, appending the vpns of the valid entries to flushed
+    auto flush(std::vector<page_type>& flushed) -> void {
+        for_each_filled([&](size_type slot) {
+            if (entries_[slot].second) {
+                flushed.push_back(vpns_[slot]);
+                entries_[slot].second = false;
+            }
+        });
+
+        // the sets fill from their first way again and the policy starts over, as after construction
+        std::fill(sizes_.begin(), sizes_.end(), 0);
+        std::fill(frees_.begin(), frees_.end(), 0);
+        if (indexed_) {
+            index_.clear();
+        }
+        RP::clear();
+    }
+
+    // the entries and the policy as they are, the index is rebuilt from them
+    auto save(SnapshotWriter& writer) const -> void {
+        writer.put(capacity_);
+        writer.put(ways_);
+        writer.put_vector(sizes_);
+        writer.put_vector(frees_);
+        writer.put_vector(free_);
+        writer.put_vector(tags_);
+        writer.put_vector(vpns_);
+        for (const auto& entry : entries_) {
+            writer.put(entry.first);
+            writer.put<uint8_t>(entry.second);
+        }
+        RP::save(writer);
+    }
+
+    auto load(SnapshotReader& reader) -> void {
+        reader.expect(capacity_, "TLB entries");
+        reader.expect(ways_, "TLB ways");
+        if (indexed_) {
+            for_each_filled([&](size_type slot) { index_.erase(vpns_[slot]); });
+        }
+
+        reader.get_vector(sizes_, "TLB sets");
+        reader.get_vector(frees_, "TLB free ways");
+        reader.get_vector(free_, "TLB free ways");
+        // the counts index the table, a damaged snapshot must not send them past a set
+        for (size_type set = 0; set <= set_mask_; ++set) {
+            if (sizes_[set] > ways_ || frees_[set] > sizes_[set]) {
+                reader.mismatch("TLB sets");
+            }
+            for (size_type i = 0; i < frees_[set]; ++i) {
+                if (free_[set * ways_ + i] >= sizes_[set]) {
+                    reader.mismatch("TLB free ways");
+                }
+            }
+        }
+
+        reader.get_vector(tags_, "TLB tags");
+        reader.get_vector(vpns_, "TLB entries");
+        for (auto& entry : entries_) {
+            entry.first = reader.get<page_type>();
+            entry.second = reader.get<uint8_t>() != 0;
+        }
+        if (indexed_) {
+            for_each_filled([&](size_type slot) { index_.insert(vpns_[slot], slot); });
+        }
+        RP::load(reader);
+    }
+
+   private:
+    template <typename F>
+    auto for_each_filled(F&& f) const -> void {
+        for (size_type set = 0; set <= set_mask_; ++set) {
+            for (size_type slot = set * ways_; slot < set * ways_ + sizes_[set]; ++slot) {
+                f(slot);
+            }
+        }
+    }
+
+    // take the way off the free ways of the set, whether it was one of them
+    auto take_free(size_type set, size_type way) -> bool {
+        auto* free = &free_[set * ways_];
+        for (size_type i = 0; i < frees_[set]; ++i) {
+            if (free[i] == way) {
+                free[i] = free[--frees_[set]];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static auto fold(page_type vpn) -> size_type { return static_cast<size_type>(vpn ^ (vpn >> 32)); }
+
+    // slot caching the vpn, or TlbIndex::kNone
+    auto find(page_type vpn) const -> size_type {
+        if (indexed_) {
+            return index_.find(vpn);
+        }
+
+        const auto set = static_cast<size_type>(vpn & set_mask_);
+        const size_type base = set * ways_;
+        auto mask = match_tags(&tags_[base], sizes_[set], fold(vpn));
+
+        // distinct VPNs folding alike are rare, but possible
+        while (mask != 0) {
+            const size_type slot = base + __builtin_ctzll(mask);
+            if (vpns_[slot] == vpn) {
+                return slot;
+            }
+            mask &= mask - 1;
+        }
+
+        return TlbIndex::kNone;
+    }
+
+   private:
+    const size_type capacity_;
+    const size_type ways_;
+    const size_type set_mask_;
+    const bool indexed_;
+    std::vector<size_type> sizes_;  // ways of every set filled once
+    std::vector<size_type> frees_;  // invalidated ways of every set, waiting in free_
+    std::vector<size_type> free_;
+    std::vector<size_type> tags_;
+    std::vector<page_type> vpns_;
+    std::vector<TlbEntry> entries_;
+    TlbIndex index_;
+
+    TlbArray(const TlbArray&) = delete;
+    TlbArray& operator=(const TlbArray&) = delete;
+};
@@ -0,0 +1,91 @@
+// tlb_chain.cc
+// TLB hierarchy fixed at compile time
+// Author: Hank Bao
+
+#include "hierarchy.h"
+#include "policy_fifo.h"
+#include "policy_lru.h"
+#include "policy_rand.h"
+#include "tlb_chain.h"
+
+// the chains compiled in, the common configurations run through make_hierarchy
+typedef ReplacementPolicyFifo Fifo;
+typedef ReplacementPolicyLru Lru;
+typedef ReplacementPolicyRand Rand;
+
+template <typename... Chains>
+struct ChainCatalog {};
+
+typedef ChainCatalog<
+    // the defaults: 64 fully associative entries, 5ns, no L2
+    TlbChain<Level<Fifo, 64, 0, 5>, PageTable>,
+    TlbChain<Level<Lru, 64, 0, 5>, PageTable>,
+    TlbChain<Level<Rand, 64, 0, 5>, PageTable>,
+    // the defaults with a fully associative LRU L2, 20ns
+    TlbChain<Level<Fifo, 64, 0, 5>, Level<Lru, 512, 0, 20>, PageTable>,
+    TlbChain<Level<Fifo, 64, 0, 5>, Level<Lru, 1024, 0, 20>, PageTable>,
+    TlbChain<Level<Lru, 64, 0, 5>, Level<Lru, 512, 0, 20>, PageTable>,
+    TlbChain<Level<Lru, 64, 0, 5>, Level<Lru, 1024, 0, 20>, PageTable>,
+    // 4-way L1 with 8-way 1024 and 12-way 1536 entry L2s, as on recent x86 cores
+    TlbChain<Level<Lru, 64, 4, 5>, Level<Lru, 1024, 8, 20>, PageTable>,
+    TlbChain<Level<Lru, 64, 4, 5>, Level<Lru, 1536, 12, 20>, PageTable>>
+    Catalog;
+
+template <typename RP>
+constexpr Policy kPolicyOf = Policy::FIFO;
+template <>
+constexpr Policy kPolicyOf<Lru> = Policy::LRU;
+template <>
+constexpr Policy kPolicyOf<Rand> = Policy::Random;
+
+template <typename L>
+struct LevelMatch {
+    static auto matches(const std::vector<LevelConfig>& levels, size_t& i) -> bool {
+        if (i >= levels.size()) {
+            return false;
+        }
+
+        const auto& level = levels[i++];
+        return level.size == L::kCapacity && level.ways == L::kWays && level.cost == L::kCost &&
+               level.policy == kPolicyOf<typename L::policy_type>;
+    }
+};
+
+template <>
+struct LevelMatch<PageTable> {
+    static auto matches(const std::vector<LevelConfig>& levels, size_t& i) -> bool {
+        // only disabled levels may follow
+        for (; i < levels.size(); ++i) {
+            if (levels[i].size != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template <typename Chain>
+struct ChainMaker;
+
+template <typename... Levels>
+struct ChainMaker<TlbChain<Levels...>> {
+    static auto make(const std::vector<LevelConfig>& levels, uint64_t seed) -> std::unique_ptr<Tlb> {
+        size_t i = 0;
+        if ((LevelMatch<Levels>::matches(levels, i) && ...)) {
+            return std::make_unique<TlbChain<Levels...>>(seed);
+        }
+        return nullptr;
+    }
+};
+
+template <typename... Chains>
+static auto make_from(ChainCatalog<Chains...>, const std::vector<LevelConfig>& levels, uint64_t seed)
+    -> std::unique_ptr<Tlb> {
+    std::unique_ptr<Tlb> tlb = nullptr;
+    ((tlb = tlb ? std::move(tlb) : ChainMaker<Chains>::make(levels, seed)), ...);
+    return tlb;
+}
+
+auto make_tlb_chain(const std::vector<LevelConfig>& levels, uint64_t seed) -> std::unique_ptr<Tlb> {
+    return make_from(Catalog{}, levels, seed);
+}
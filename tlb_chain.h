@@ -0,0 +1,147 @@
+// tlb_chain.h
+// TLB hierarchy fixed at compile time
+// Author: Hank Bao
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "def.h"
+#include "level_stats.h"
+#include "tlb.h"
+#include "tlb_array.h"
+
+struct LevelConfig;
+
+// one level of a TlbChain, 0 ways meaning fully associative
+template <typename RP, size_type Capacity, size_type Ways, time_type Cost>
+struct Level {
+    typedef RP policy_type;
+    static constexpr size_type kCapacity = Capacity;
+    static constexpr size_type kWays = Ways;
+    static constexpr time_type kCost = Cost;
+};
+
+// the end of a TlbChain, where every lookup misses
+struct PageTable {};
+
+template <typename... Levels>
+class TlbLink;
+
+template <>
+class TlbLink<PageTable> {
+   public:
+    TlbLink(uint64_t seed) {}
+
+    auto lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> { return std::nullopt; }
+    auto insert(page_type vpn, page_type pfn, bool valid) -> void {}
+    auto probe(page_type vpn) const -> bool { return false; }
+    auto invalidate(page_type vpn) -> void {}
+    auto flush(std::vector<page_type>& flushed) -> void {}
+    auto level_stats(std::vector<LevelStats>& stats) const -> void {}
+    auto classify_misses() -> void {}
+    auto save(SnapshotWriter& writer) const -> void {}
+    auto load(SnapshotReader& reader) -> void {}
+};
+
+template <typename L, typename... Rest>
+class TlbLink<L, Rest...> {
+   public:
+    TlbLink(uint64_t seed) : array_{L::kCapacity, L::kWays, seed}, next_{seed + 1}, counters_{L::kCapacity, false} {}
+
+    auto lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> {
+        const auto entry = array_.lookup(vpn);
+        counters_.lookup(vpn, entry != nullptr);
+        if (entry != nullptr) {
+            return std::pair(entry->first, L::kCost);
+        } else {
+            return next_.lookup(vpn);
+        }
+    }
+
+    auto insert(page_type vpn, page_type pfn, bool valid) -> void {
+        auto evictee = array_.insert(vpn, pfn, valid);
+        counters_.insert();
+        if (evictee && evictee->entry.second) {
+            counters_.evict();
+            next_.insert(evictee->vpn, evictee->entry.first, evictee->entry.second);
+        }
+    }
+
+    auto probe(page_type vpn) const -> bool { return array_.probe(vpn) || next_.probe(vpn); }
+
+    auto invalidate(page_type vpn) -> void {
+        array_.invalidate(vpn);
+        next_.invalidate(vpn);
+    }
+
+    auto flush(std::vector<page_type>& flushed) -> void {
+        array_.flush(flushed);
+        next_.flush(flushed);
+    }
+
+    auto level_stats(std::vector<LevelStats>& stats) const -> void {
+        stats.push_back(counters_.stats());
+        next_.level_stats(stats);
+    }
+
+    auto classify_misses() -> void {
+        counters_.enable_classification();
+        next_.classify_misses();
+    }
+
+    auto save(SnapshotWriter& writer) const -> void {
+        array_.save(writer);
+        next_.save(writer);
+    }
+
+    auto load(SnapshotReader& reader) -> void {
+        array_.load(reader);
+        next_.load(reader);
+    }
+
+   private:
+    TlbArray<typename L::policy_type> array_;
+    TlbLink<Rest...> next_;
+    LevelCounters counters_;
+};
+
+// A whole hierarchy as one type, e.g.
+//     TlbChain<Level<ReplacementPolicyLru, 64, 4, 5>, Level<ReplacementPolicyLru, 1536, 12, 20>, PageTable>
+// Levels hold each other by value, so a lookup or insert costs one virtual
+// call at the top and the walk down the levels is inlined. Level i is
+// seeded with seed + i, as in make_hierarchy, so both give the same results.
+template <typename... Levels>
+class TlbChain final : public Tlb {
+   public:
+    TlbChain(uint64_t seed) : Tlb{}, chain_{seed} {}
+    virtual ~TlbChain() = default;
+
+    virtual auto lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> override {
+        return chain_.lookup(vpn);
+    }
+
+    virtual auto insert(page_type vpn, page_type pfn, bool valid) -> void override {
+        chain_.insert(vpn, pfn, valid);
+    }
+
+    virtual auto probe(page_type vpn) const -> bool override { return chain_.probe(vpn); }
+    virtual auto invalidate(page_type vpn) -> void override { chain_.invalidate(vpn); }
+    virtual auto flush(std::vector<page_type>& flushed) -> void override { chain_.flush(flushed); }
+    virtual auto level_stats(std::vector<LevelStats>& stats) const -> void override { chain_.level_stats(stats); }
+    virtual auto classify_misses() -> void override { chain_.classify_misses(); }
+    virtual auto save(SnapshotWriter& writer) const -> void override { chain_.save(writer); }
+    virtual auto load(SnapshotReader& reader) -> void override { chain_.load(reader); }
+
+   private:
+    TlbLink<Levels...> chain_;
+
+    TlbChain(const TlbChain&) = delete;
+    TlbChain& operator=(const TlbChain&) = delete;
+};
+
+// the precompiled chain for the levels (trailing disabled levels ignored), or nullptr
+auto make_tlb_chain(const std::vector<LevelConfig>& levels, uint64_t seed) -> std::unique_ptr<Tlb>;
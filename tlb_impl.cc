@@ -2,22 +2,25 @@
 // TLB implementation
 // Author: Hank Bao
 
-#include <cassert>
-
 #include "tlb_impl.h"
+#include "policy_clock.h"
 #include "policy_fifo.h"
+#include "policy_lfu.h"
 #include "policy_lru.h"
+#include "policy_plru.h"
 #include "policy_rand.h"
+#include "policy_rrip.h"
 
 template <typename RP>
-auto TlbImpl<RP>::lookup(size_type vpn) -> std::optional<std::pair<size_type, time_type>> {
+auto TlbImpl<RP>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> {
     // lookup in current level
-    const auto it = cache_.find(vpn);
+    const auto entry = array_.lookup(vpn);
+    counters_.lookup(vpn, entry != nullptr);
 
     // search cache
-    if (it != cache_.end()) {
+    if (entry != nullptr) {
         // tlb hit
-        return std::pair(it->second.first, cost_);
+        return std::pair(entry->first, cost_);
     } else {
         // tlb miss, try next level
         return next_->lookup(vpn);
@@ -25,26 +28,143 @@ auto TlbImpl<RP>::lookup(size_type vpn) -> std::optional<std::pair<size_type, ti
 }
 
 template <typename RP>
-auto TlbImpl<RP>::insert(size_type vpn, size_type pfn, bool valid) -> void {
-    auto entry = RP::replace(cache_, capacity_, vpn, pfn, valid);
-    if (entry) {
-        assert(cache_.size() == capacity_);
-
-        auto vpn = entry->first;
-        auto pfn = entry->second.first;
-        auto valid = entry->second.second;
-
+auto TlbImpl<RP>::insert(page_type vpn, page_type pfn, bool valid) -> void {
+    auto evictee = array_.insert(vpn, pfn, valid);
+    counters_.insert();
+    if (evictee && evictee->entry.second) {
         // put the evictee one into next level
-        next_->insert(vpn, pfn, valid);
-    } else {
-        assert(cache_.size() < capacity_);
+        counters_.evict();
+        next_->insert(evictee->vpn, evictee->entry.first, evictee->entry.second);
     }
 }
 
-template auto TlbImpl<ReplacementPolicyFifo>::lookup(size_type vpn) -> std::optional<std::pair<size_type, time_type>>;
-template auto TlbImpl<ReplacementPolicyLru>::lookup(size_type vpn) -> std::optional<std::pair<size_type, time_type>>;
-template auto TlbImpl<ReplacementPolicyRand>::lookup(size_type vpn) -> std::optional<std::pair<size_type, time_type>>;
+template <typename RP>
+auto TlbImpl<RP>::probe(page_type vpn) const -> bool {
+    return array_.probe(vpn) || next_->probe(vpn);
+}
+
+template <typename RP>
+auto TlbImpl<RP>::invalidate(page_type vpn) -> void {
+    array_.invalidate(vpn);
+    next_->invalidate(vpn);
+}
+
+template <typename RP>
+auto TlbImpl<RP>::flush(std::vector<page_type>& flushed) -> void {
+    array_.flush(flushed);
+    next_->flush(flushed);
+}
+
+template <typename RP>
+auto TlbImpl<RP>::level_stats(std::vector<LevelStats>& stats) const -> void {
+    stats.push_back(counters_.stats());
+    next_->level_stats(stats);
+}
+
+template <typename RP>
+auto TlbImpl<RP>::classify_misses() -> void {
+    counters_.enable_classification();
+    next_->classify_misses();
+}
+
+template <typename RP>
+auto TlbImpl<RP>::save(SnapshotWriter& writer) const -> void {
+    array_.save(writer);
+    next_->save(writer);
+}
+
+template <typename RP>
+auto TlbImpl<RP>::load(SnapshotReader& reader) -> void {
+    array_.load(reader);
+    next_->load(reader);
+}
+
+template auto TlbImpl<ReplacementPolicyFifo>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicyLru>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicyRand>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicyClock>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicyPlru>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicySrrip>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicyBrrip>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicyDrrip>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+template auto TlbImpl<ReplacementPolicyLfu>::lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>>;
+
+template auto TlbImpl<ReplacementPolicyFifo>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyLru>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyRand>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyClock>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyPlru>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicySrrip>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyBrrip>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyDrrip>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyLfu>::insert(page_type vpn, page_type pfn, bool valid) -> void;
+
+template auto TlbImpl<ReplacementPolicyFifo>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicyLru>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicyRand>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicyClock>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicyPlru>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicySrrip>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicyBrrip>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicyDrrip>::probe(page_type vpn) const -> bool;
+template auto TlbImpl<ReplacementPolicyLfu>::probe(page_type vpn) const -> bool;
+
+template auto TlbImpl<ReplacementPolicyFifo>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicyLru>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicyRand>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicyClock>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicyPlru>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicySrrip>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicyBrrip>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicyDrrip>::invalidate(page_type vpn) -> void;
+template auto TlbImpl<ReplacementPolicyLfu>::invalidate(page_type vpn) -> void;
+
+template auto TlbImpl<ReplacementPolicyFifo>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicyLru>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicyRand>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicyClock>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicyPlru>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicySrrip>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicyBrrip>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicyDrrip>::flush(std::vector<page_type>& flushed) -> void;
+template auto TlbImpl<ReplacementPolicyLfu>::flush(std::vector<page_type>& flushed) -> void;
+
+template auto TlbImpl<ReplacementPolicyFifo>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicyLru>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicyRand>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicyClock>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicyPlru>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicySrrip>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicyBrrip>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicyDrrip>::level_stats(std::vector<LevelStats>& stats) const -> void;
+template auto TlbImpl<ReplacementPolicyLfu>::level_stats(std::vector<LevelStats>& stats) const -> void;
+
+template auto TlbImpl<ReplacementPolicyFifo>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicyLru>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicyRand>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicyClock>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicyPlru>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicySrrip>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicyBrrip>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicyDrrip>::classify_misses() -> void;
+template auto TlbImpl<ReplacementPolicyLfu>::classify_misses() -> void;
+
+template auto TlbImpl<ReplacementPolicyFifo>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicyLru>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicyRand>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicyClock>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicyPlru>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicySrrip>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicyBrrip>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicyDrrip>::save(SnapshotWriter& writer) const -> void;
+template auto TlbImpl<ReplacementPolicyLfu>::save(SnapshotWriter& writer) const -> void;
 
-template auto TlbImpl<ReplacementPolicyFifo>::insert(size_type vpn, size_type pfn, bool valid) -> void;
-template auto TlbImpl<ReplacementPolicyLru>::insert(size_type vpn, size_type pfn, bool valid) -> void;
-template auto TlbImpl<ReplacementPolicyRand>::insert(size_type vpn, size_type pfn, bool valid) -> void;
+template auto TlbImpl<ReplacementPolicyFifo>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicyLru>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicyRand>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicyClock>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicyPlru>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicySrrip>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicyBrrip>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicyDrrip>::load(SnapshotReader& reader) -> void;
+template auto TlbImpl<ReplacementPolicyLfu>::load(SnapshotReader& reader) -> void;
@@ -4,34 +4,43 @@
 
 #pragma once
 
-#include <map>
 #include <memory>
 #include <utility>
 
 #include "def.h"
-#include "policy.h"
+#include "level_stats.h"
 #include "tlb.h"
+#include "tlb_array.h"
 
+// One level of a hierarchy assembled at run time: the entries are kept in
+// a TlbArray and misses and evictions go to whatever TLB comes next.
 template <typename RP>
-class TlbImpl : public Tlb, private RP {
+class TlbImpl : public Tlb {
    public:
-    TlbImpl(const time_type cost, const size_type capacity, std::unique_ptr<Tlb>&& next)
+    TlbImpl(const time_type cost, const size_type capacity, const size_type ways, const uint64_t seed,
+            const bool shared, std::unique_ptr<Tlb>&& next)
         : Tlb{},
-          RP{capacity},
           cost_{cost},
-          capacity_{capacity},
-          cache_{},
-          next_{std::forward<decltype(next)>(next)} {}
+          array_{capacity, ways, seed},
+          next_{std::forward<decltype(next)>(next)},
+          counters_{capacity, shared} {}
     virtual ~TlbImpl() = default;
 
-    virtual auto lookup(size_type vpn) -> std::optional<std::pair<size_type, time_type>> override;
-    virtual auto insert(size_type vpn, size_type pfn, bool valid) -> void override;
+    virtual auto lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> override;
+    virtual auto insert(page_type vpn, page_type pfn, bool valid) -> void override;
+    virtual auto probe(page_type vpn) const -> bool override;
+    virtual auto invalidate(page_type vpn) -> void override;
+    virtual auto flush(std::vector<page_type>& flushed) -> void override;
+    virtual auto level_stats(std::vector<LevelStats>& stats) const -> void override;
+    virtual auto classify_misses() -> void override;
+    virtual auto save(SnapshotWriter& writer) const -> void override;
+    virtual auto load(SnapshotReader& reader) -> void override;
 
    private:
     const time_type cost_;
-    const size_t capacity_;
-    std::map<size_type, TlbEntry> cache_;
+    TlbArray<RP> array_;
     std::unique_ptr<Tlb> next_;
+    LevelCounters counters_;
 
     TlbImpl(const TlbImpl&) = delete;
     TlbImpl& operator=(const TlbImpl&) = delete;
@@ -0,0 +1,101 @@
+// tlb_index.h
+// Open-addressed index from VPN to the slot holding its TLB entry
+// Author: Hank Bao
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "def.h"
+
+// Linear probing over a power-of-two bucket array sized once from the
+// capacity of the TLB, kept at most half full. Buckets carry the VPN so a
+// probe never leaves the array, and erasing shifts the following buckets
+// back instead of leaving tombstones, so lookups stay short in the steady
+// state where every miss erases one VPN and adds another.
+class TlbIndex {
+   public:
+    static constexpr size_type kNone = ~size_type{0};
+
+    TlbIndex(size_type capacity)
+        : buckets_(bucket_count(capacity)), mask_{buckets_.size() - 1}, shift_{64 - bucket_bits(buckets_.size())} {}
+    ~TlbIndex() = default;
+
+    // slot of the vpn, or kNone if it is not indexed
+    auto find(page_type vpn) const -> size_type {
+        for (size_t i = home(vpn);; i = (i + 1) & mask_) {
+            const Bucket& b = buckets_[i];
+            if (b.slot == kNone || b.vpn == vpn) {
+                return b.slot;
+            }
+        }
+    }
+
+    // the vpn must not be indexed yet
+    auto insert(page_type vpn, size_type slot) -> void {
+        size_t i = home(vpn);
+        while (buckets_[i].slot != kNone) {
+            i = (i + 1) & mask_;
+        }
+
+        buckets_[i] = Bucket{vpn, slot};
+    }
+
+    auto clear() -> void { std::fill(buckets_.begin(), buckets_.end(), Bucket{}); }
+
+    auto erase(page_type vpn) -> void {
+        size_t i = home(vpn);
+        while (buckets_[i].vpn != vpn || buckets_[i].slot == kNone) {
+            if (buckets_[i].slot == kNone) {
+                return;
+            }
+            i = (i + 1) & mask_;
+        }
+
+        // shift back every following bucket whose home is not between the hole and itself
+        for (size_t j = (i + 1) & mask_; buckets_[j].slot != kNone; j = (j + 1) & mask_) {
+            size_t k = home(buckets_[j].vpn);
+            bool movable = i <= j ? (k <= i || k > j) : (k <= i && k > j);
+            if (movable) {
+                buckets_[i] = buckets_[j];
+                i = j;
+            }
+        }
+
+        buckets_[i] = Bucket{};
+    }
+
+   private:
+    struct Bucket {
+        page_type vpn = 0;
+        size_type slot = kNone;
+    };
+
+    static auto bucket_count(size_type capacity) -> size_t {
+        size_t n = 2;
+        while (n < 2 * static_cast<size_t>(capacity)) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static auto bucket_bits(size_t n) -> unsigned {
+        unsigned bits = 0;
+        while ((size_t{1} << bits) < n) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // fibonacci hashing, spreads the sequential VPNs of a scan across the buckets
+    auto home(page_type vpn) const -> size_t {
+        return static_cast<size_t>((vpn * 0x9e3779b97f4a7c15ull) >> shift_);
+    }
+
+   private:
+    std::vector<Bucket> buckets_;
+    const size_t mask_;
+    const unsigned shift_;
+};
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "def.h"
+#include "level_stats.h"
 #include "tlb.h"
 
 class TlbNull : public Tlb {
@@ -12,8 +13,15 @@ class TlbNull : public Tlb {
     TlbNull() = default;
     virtual ~TlbNull() = default;
 
-    virtual auto lookup(size_type vpn) -> std::optional<std::pair<size_type, time_type>> override { return std::nullopt; }
-    virtual auto insert(size_type vpn, size_type pfn, bool valid) -> void override {}
+    virtual auto lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> override { return std::nullopt; }
+    virtual auto insert(page_type vpn, page_type pfn, bool valid) -> void override {}
+    virtual auto probe(page_type vpn) const -> bool override { return false; }
+    virtual auto invalidate(page_type vpn) -> void override {}
+    virtual auto flush(std::vector<page_type>& flushed) -> void override {}
+    virtual auto level_stats(std::vector<LevelStats>& stats) const -> void override {}
+    virtual auto classify_misses() -> void override {}
+    virtual auto save(SnapshotWriter& writer) const -> void override {}
+    virtual auto load(SnapshotReader& reader) -> void override {}
 
    private:
     TlbNull(const TlbNull&) = delete;
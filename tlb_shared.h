@@ -0,0 +1,75 @@
+// tlb_shared.h
+// TLB level shared by several hierarchies
+// Author: Hank Bao
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "def.h"
+#include "level_stats.h"
+#include "tlb.h"
+
+// A level owned jointly by several chains, e.g. one last-level TLB behind the
+// private L1s of several cores. Its sets are locked in stripes, so cores
+// touching different sets never wait for each other; a stripe must cover
+// whole sets and everything the policy keeps about them.
+struct SharedLevel {
+    SharedLevel(std::unique_ptr<Tlb>&& tlb, size_type stripes)
+        : tlb{std::move(tlb)}, locks(stripes), mask{stripes - 1} {}
+
+    // the lock of the set of the vpn, stripes being a power of 2 dividing the sets
+    auto lock(page_type vpn) -> std::mutex& { return locks[vpn & mask]; }
+
+    std::unique_ptr<Tlb> tlb;
+    std::vector<std::mutex> locks;
+    const page_type mask;
+};
+
+// Stands in for a shared level in the chain of one of its owners.
+class TlbShared : public Tlb {
+   public:
+    TlbShared(std::shared_ptr<SharedLevel> level) : Tlb{}, level_{std::move(level)} {}
+    virtual ~TlbShared() = default;
+
+    virtual auto lookup(page_type vpn) -> std::optional<std::pair<page_type, time_type>> override {
+        std::lock_guard<std::mutex> guard{level_->lock(vpn)};
+        return level_->tlb->lookup(vpn);
+    }
+    virtual auto insert(page_type vpn, page_type pfn, bool valid) -> void override {
+        std::lock_guard<std::mutex> guard{level_->lock(vpn)};
+        level_->tlb->insert(vpn, pfn, valid);
+    }
+    virtual auto probe(page_type vpn) const -> bool override {
+        std::lock_guard<std::mutex> guard{level_->lock(vpn)};
+        return level_->tlb->probe(vpn);
+    }
+    virtual auto invalidate(page_type vpn) -> void override {
+        std::lock_guard<std::mutex> guard{level_->lock(vpn)};
+        level_->tlb->invalidate(vpn);
+    }
+    virtual auto flush(std::vector<page_type>& flushed) -> void override {
+        // every stripe, always taken in the same order
+        for (auto& lock : level_->locks) {
+            lock.lock();
+        }
+        level_->tlb->flush(flushed);
+        for (auto& lock : level_->locks) {
+            lock.unlock();
+        }
+    }
+    // read and set up while no core is running
+    virtual auto level_stats(std::vector<LevelStats>& stats) const -> void override { level_->tlb->level_stats(stats); }
+    virtual auto classify_misses() -> void override { level_->tlb->classify_misses(); }
+    virtual auto save(SnapshotWriter& writer) const -> void override { level_->tlb->save(writer); }
+    virtual auto load(SnapshotReader& reader) -> void override { level_->tlb->load(reader); }
+
+   private:
+    std::shared_ptr<SharedLevel> level_;
+
+   private:
+    TlbShared(const TlbShared&) = delete;
+    TlbShared& operator=(const TlbShared&) = delete;
+};
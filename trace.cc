@@ -0,0 +1,217 @@
+// trace.cc
+// Memory-mapped trace reader streaming addresses from a file
+// Author: Hank Bao
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+// give the consumed part of the mapping back to the kernel every so often,
+// so the resident set stays constant however long the trace is
+static constexpr size_t kReleaseChunk = 64 * 1024 * 1024;
+
+TraceReader::TraceReader(const std::string& path, TraceFormat format)
+    : path_{path}, format_{format}, fd_{-1}, data_{nullptr}, size_{0}, pos_{0}, released_{0} {
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::fprintf(stderr, "Cannot open trace %s: %s\n", path.c_str(), std::strerror(errno));
+        ::exit(EXIT_FAILURE);
+    }
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        std::fprintf(stderr, "Cannot stat trace %s: %s\n", path.c_str(), std::strerror(errno));
+        ::exit(EXIT_FAILURE);
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        // nothing to map, the trace is simply empty
+        return;
+    }
+
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (p == MAP_FAILED) {
+        std::fprintf(stderr, "Cannot map trace %s: %s\n", path.c_str(), std::strerror(errno));
+        ::exit(EXIT_FAILURE);
+    }
+
+    ::madvise(p, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(p);
+
+    size_t word = format_ == TraceFormat::Binary ? sizeof(uint32_t) : sizeof(uint64_t);
+    if (format_ != TraceFormat::Text && size_ % word != 0) {
+        std::fprintf(stderr, "Trailing %zu bytes in binary trace %s ignored\n", size_ % word, path.c_str());
+    }
+}
+
+TraceReader::~TraceReader() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+auto TraceReader::next(addr_type& addr) -> bool {
+    if (pos_ - released_ >= kReleaseChunk) {
+        release_consumed();
+    }
+
+    switch (format_) {
+        case TraceFormat::Text:
+            return next_text(addr);
+        case TraceFormat::Binary:
+            return next_binary<uint32_t>(addr);
+        case TraceFormat::Binary64:
+            return next_binary<uint64_t>(addr);
+        default:
+            std::abort();
+    }
+}
+
+auto TraceReader::read(addr_type* addrs, size_t max) -> size_t {
+    size_t n = 0;
+    while (n < max && next(addrs[n])) {
+        ++n;
+    }
+
+    return n;
+}
+
+template <typename Word>
+auto TraceReader::next_binary(addr_type& addr) -> bool {
+    if (size_ - pos_ < sizeof(Word)) {
+        return false;
+    }
+
+    Word word;
+    std::memcpy(&word, data_ + pos_, sizeof(Word));
+    pos_ += sizeof(Word);
+    addr = word;
+
+    if (is_context_switch(addr) && switch_asid(addr) >= (asid_type{1} << kAsidBits)) {
+        std::fprintf(stderr, "Invalid ASID at offset %zu in trace %s\n", pos_ - sizeof(Word), path_.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+
+    return true;
+}
+
+static auto digit_value(char c) -> int {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else {
+        return 64;
+    }
+}
+
+auto TraceReader::next_text(addr_type& addr) -> bool {
+    const char* p = data_ + pos_;
+    const char* end = data_ + size_;
+
+    // skip separators and comments
+    while (p < end) {
+        if (*p == '#') {
+            while (p < end && *p != '\n') {
+                ++p;
+            }
+        } else if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') {
+            ++p;
+        } else {
+            break;
+        }
+    }
+
+    if (p == end) {
+        pos_ = size_;
+        return false;
+    }
+
+    // @ASID switches to another address space, !ADDR unmaps a page
+    const char* start = p;
+    bool switching = *p == '@';
+    bool unmapping = *p == '!';
+    if (switching || unmapping) {
+        ++p;
+    }
+
+    // same notations as str_to_num: 0x for hex, 0b for binary, 0 for octal
+    int base = 10;
+    if (*p == '0' && p + 1 < end) {
+        if (p[1] == 'x' || p[1] == 'X') {
+            base = 16;
+            p += 2;
+        } else if (p[1] == 'b' || p[1] == 'B') {
+            base = 2;
+            p += 2;
+        } else {
+            base = 8;
+        }
+    }
+
+    addr_type value = 0;
+    int digits = 0;
+    while (p < end) {
+        int d = digit_value(*p);
+        if (d >= base) {
+            break;
+        }
+
+        value = value * base + d;
+        ++digits;
+        ++p;
+    }
+
+    bool separated = p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',' || *p == '#';
+    if (digits == 0 || !separated) {
+        std::fprintf(stderr, "Invalid address at offset %zu in trace %s\n",
+                     static_cast<size_t>(start - data_), path_.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+
+    if (switching && value >= (addr_type{1} << kAsidBits)) {
+        std::fprintf(stderr, "Invalid ASID at offset %zu in trace %s\n",
+                     static_cast<size_t>(start - data_), path_.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+    if (unmapping && value > kUnmapAddressMask) {
+        std::fprintf(stderr, "Invalid unmap at offset %zu in trace %s\n",
+                     static_cast<size_t>(start - data_), path_.c_str());
+        ::exit(EXIT_FAILURE);
+    }
+
+    pos_ = p - data_;
+    if (switching) {
+        addr = context_switch(static_cast<asid_type>(value));
+    } else if (unmapping) {
+        addr = unmap(value);
+    } else {
+        addr = value;
+    }
+
+    return true;
+}
+
+auto TraceReader::release_consumed() -> void {
+    // only whole pages can be dropped
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t upto = pos_ & ~(page - 1);
+    if (upto > released_) {
+        ::madvise(const_cast<char*>(data_) + released_, upto - released_, MADV_DONTNEED);
+        released_ = upto;
+    }
+}
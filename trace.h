@@ -0,0 +1,53 @@
+// trace.h
+// Memory-mapped trace reader streaming addresses from a file
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "def.h"
+
+enum class TraceFormat {
+    Text,
+    Binary,    // 32-bit words
+    Binary64,  // 64-bit words
+};
+
+// Streams the addresses of a trace file without loading it into memory.
+// Text traces hold one address per token (separated by whitespace or commas,
+// '#' starts a comment till the end of line) in the same notations as -a.
+// Binary traces are a raw array of native-endian 32-bit or 64-bit addresses.
+// Context switches and unmaps are "@ASID" and "!ADDR" tokens in text traces
+// and context_switch() and unmap() words in 64-bit binary traces; 32-bit
+// words have no room for them.
+class TraceReader {
+   public:
+    TraceReader(const std::string& path, TraceFormat format);
+    ~TraceReader();
+
+    // fetch the next address, returns false at the end of the trace
+    auto next(addr_type& addr) -> bool;
+    // fetch up to max addresses, returns how many, 0 at the end of the trace
+    auto read(addr_type* addrs, size_t max) -> size_t;
+
+   private:
+    auto next_text(addr_type& addr) -> bool;
+    template <typename Word>
+    auto next_binary(addr_type& addr) -> bool;
+    auto release_consumed() -> void;
+
+   private:
+    const std::string path_;
+    const TraceFormat format_;
+    int fd_;
+    const char* data_;
+    size_t size_;
+    size_t pos_;
+    size_t released_;
+
+   private:
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+};
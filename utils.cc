@@ -3,6 +3,7 @@
 // Author: Hank Bao
 
 #include <cassert>
+#include <cctype>
 #include <cstdio>
 #include <cstdlib>
 #include <sstream>
@@ -12,16 +13,74 @@
 [[noreturn]] auto print_usage(bool onerror) -> void {
     std::puts("Usage: tlb [OPTIONS]...\n");
     std::puts("Supported options:");
-    std::puts("-s, --size=PAGESIZE\n\tsize of a page in bytes, must be a power of 2, default to 4096");
+    std::puts("-s, --size=PAGESIZE\n\tsize of a page in bytes, must be a power of 2 of at least 4K, K, M or G suffixed,\n\tdefault to 4096");
     std::puts("-t, --tlb=TLBSIZE\n\tsize of the TLB L1, default to 64");
+    std::puts("-w, --ways=TLBWAYS\n\tassociativity of the TLB L1, default to fully associative");
+    std::puts("--sets=TLBSETS\n\tnumber of sets of the TLB L1, a power of 2, instead of its ways");
     std::puts("-c, --cost=TLBCOST\n\tcost of lookup in the TLB L1, default to 5 nano seconds");
     std::puts("-l, --tlb2=TLBSIZE2\n\tsize of the TLB L2, disable by setting to 0, default to 0");
+    std::puts("-W, --ways2=TLBWAYS2\n\tassociativity of the TLB L2, default to fully associative");
+    std::puts("--sets2=TLBSETS2\n\tnumber of sets of the TLB L2, a power of 2, instead of its ways");
     std::puts("-d, --cost2=TLBCOST2\n\tcost of lookup in the TLB L2, default to 20 nano seconds");
-    std::puts("-e, --costpt=PTBCOST\n\tcost of lookup in the Page Table, default to 100 nano seconds");
-    std::puts("-p, --policy=TLBPOLICY\n\treplacement policy for TLB L1 (FIFO, LRU, RAND), default to FIFO");
-    std::puts("-q, --policy2=TLBPOLICY2\n\treplacement policy for TLB L2 (FIFO, LRU, RAND), default to LRU");
-    std::puts("-a, --access=ADDRLIST\n\ta set of comma-separated addresses to access, required");
+    std::puts("-e, --costpt=PTBCOST\n\tcost of lookup in the Page Table, or of every entry read from memory by a walk,\n"
+              "\tdefault to 100 nano seconds");
+    std::puts("-p, --policy=TLBPOLICY\n\treplacement policy for TLB L1 (FIFO, LRU, RAND, CLOCK, PLRU, SRRIP, BRRIP, DRRIP, LFU), default to FIFO");
+    std::puts("-q, --policy2=TLBPOLICY2\n\treplacement policy for TLB L2 (FIFO, LRU, RAND, CLOCK, PLRU, SRRIP, BRRIP, DRRIP, LFU), default to LRU");
+    std::puts("--level=SIZE:COST:POLICY[:WAYS][:shared]\n\tappend a TLB level, repeatable, replaces the L1 and L2 options above,\n"
+              "\ta size of 0 disables the level, only the last level can be shared");
+    std::puts("--hierarchy=FILE\n\tappend the levels of FILE, one --level value per line, '#' starting a comment");
+    std::puts("--region=START:LENGTH:PAGESIZE\n\tmap LENGTH bytes from START with pages of PAGESIZE instead of -s, repeatable");
+    std::puts("--pagemap=FILE\n\tadd the regions of FILE, one --region value per line, '#' starting a comment");
+    std::puts("--pagetlb=PAGESIZE:SIZE:COST:POLICY[:WAYS]\n\tL1 of the TLBs caching the pages of PAGESIZE, default to the L1 above");
+    std::puts("--walk=LEVELS[:PWCSIZE[:CACHELINES]]\n\twalk a radix page table of 4 or 5 levels on misses, with PWCSIZE entries cached\n"
+              "\tper upper level and CACHELINES page-table lines in the data caches, default to 0:32:512 (flat)");
+    std::puts("--costwalk=PWCCOST:LINECOST\n\tcost of probing the paging-structure caches and of an entry found in the\n"
+              "\tdata caches, default to 1:5 nano seconds");
+    std::puts("--frames=FRAMES\n\tphysical frames of every page size, pages beyond are swapped out, default to 0 (unlimited)");
+    std::puts("--pagepolicy=POLICY\n\treplacement policy for the frames (FIFO, LRU, RAND, CLOCK, PLRU, SRRIP, BRRIP, DRRIP, LFU), default to LRU");
+    std::puts("--costfault=MINOR[:MAJOR]\n\tcost of the first fault of a page and of reading a swapped out page back in,\n"
+              "\tdefault to 1000:100000 nano seconds");
+    std::puts("--prefetcher=KIND[:DEGREE]\n\tprefetch on TLB misses (none, seq, stride, distance), DEGREE pages ahead,\n"
+              "\tdefault to none:1");
+    std::puts("--prefetchbuf=SIZE[:COST]\n\tentries of the prefetch buffer and cost of a lookup in it, default to 16:1");
+    std::puts("--asid=MODE[:COST]\n\ton context switches flush the TLBs at COST or keep entries tagged with their ASID\n"
+              "\t(flush, tagged), default to flush:100");
+    std::puts("--core=FILE\n\tadd a core replaying the trace FILE on a thread of its own, repeatable, the levels\n"
+              "\tmarked shared being one for all cores, !ADDR records shooting the page down on the others");
+    std::puts("--shootdown=IPI[:HANDLER]\n\tcost of a shootdown to the core unmapping and to every other core,\n"
+              "\tdefault to 2000:500 nano seconds");
+    std::puts("--seed=SEED\n\tseed of the random replacement policies, default to 0");
+    std::puts("-a, --access=ADDRLIST\n\ta set of comma-separated addresses to access, @ASID switches the address space,\n"
+              "\t!ADDR unmaps the page of ADDR, required unless a trace or a generator is given");
     std::puts("-f, --prefetch=PREFETCHLIST\n\ta set of comma-separated addresses to prefetch, default to none");
+    std::puts("-T, --trace=FILE\n\ta trace file streamed through the MMU instead of the addresses given by -a");
+    std::puts("--gen=KIND:COUNT:PAGES[:STRIDE|ALPHA][:SEED]\n\tgenerate COUNT accesses over PAGES pages instead of -a or -T (uniform, zipf\n"
+              "\twith skew ALPHA, stride of STRIDE bytes, loop, chase), repeatable, one phase after another");
+    std::puts("--genrounds=ROUNDS\n\trepeat the generated phases ROUNDS times, default to 1");
+    std::puts("-F, --format=TRACEFORMAT\n\tformat of the trace file (text, bin, bin64), default to text");
+    std::puts("-Q, --quiet\n\tprint the final statistics only, not every access");
+    std::puts("-o, --log=FILE\n\twrite a machine-readable record of every access to FILE, '-' for stdout");
+    std::puts("-O, --logformat=LOGFORMAT\n\tformat of the access log (csv, bin), default to csv");
+    std::puts("--interval=ACCESSES:FILE\n\twrite the accesses, hits, misses per thousand accesses and cost, overall and per TLB level,\n"
+              "\tof every ACCESSES accesses to FILE ('-' for stdout) in the -O format");
+    std::puts("--checkpoint=REFERENCES:FILE\n\tsave the TLBs, their policies and the page-walk caches to FILE once REFERENCES\n"
+              "\treferences of the stream have run, context switches and unmaps included");
+    std::puts("--restore=FILE\n\tstart from the state saved in FILE and skip the references it had seen,\n"
+              "\tthe TLB options must match those it was saved with");
+    std::puts("--sweep=GRID\n\treplay the accesses through every configuration of GRID and print one table,\n"
+              "\tGRID being KEY=VALUE[,VALUE]...[;KEY=...] with the long option names above as keys,\n"
+              "\ttlbN, waysN, costN and policyN addressing level N");
+    std::puts("--shards=SHARDS\n\tsplit the pages by TLB set into SHARDS (a power of 2) replayed in parallel with the\n"
+              "\tsame results, per-access lines are not printed");
+    std::puts("--sample=sets:SAMPLED:GROUPS|time:PERIOD:WINDOW[:WARMUP]\n\tsimulate SAMPLED of GROUPS groups of sets, or "
+              "WINDOW accesses after WARMUP ones every PERIOD,\n\tand estimate the hit rate and average cost with 95% confidence "
+              "intervals");
+    std::puts("--threads=THREADS\n\tworker threads of a sweep or of shards, default to the number of cores");
+    std::puts("--levelstats\n\tprint the hits, misses, insertions and evictions of every TLB level, its misses\n"
+              "\tsplit into compulsory, capacity and conflict ones and a histogram of its reuse distances");
+    std::puts("--dynamic\n\tchain the TLB levels at run time even when the configuration is precompiled");
+    std::puts("--mrc[=FILE]\n\tprint the miss ratio of a fully associative LRU TLB of every size in one pass,\n"
+              "\tor write the complete curve to FILE as CSV");
     std::puts("-h, --help\n\tprint usage message and exit");
 
     ::exit(onerror ? EXIT_FAILURE : EXIT_SUCCESS);
@@ -46,7 +105,7 @@ auto begins_with(const std::string& s, const std::string& prefix) -> bool {
     return s.length() >= prefix.length() ? s.compare(0, prefix.length(), prefix) == 0 : false;
 }
 
-auto str_to_num(const std::string& s) -> uint32_t {
+auto str_to_num(const std::string& s) -> uint64_t {
     assert(!s.empty());
 
     int base = 10;
@@ -58,10 +117,10 @@ auto str_to_num(const std::string& s) -> uint32_t {
         base = 8;
     }
 
-    return std::strtoul(s.c_str(), nullptr, base);
+    return std::strtoull(s.c_str(), nullptr, base);
 }
 
-auto num_to_str_hex(uint32_t n) -> std::string {
+auto num_to_str_hex(uint64_t n) -> std::string {
     std::stringstream ss;
     ss << "0x" << std::hex << n;
     return ss.str();
@@ -75,15 +134,45 @@ auto policy_to_string(const Policy& policy) -> std::string {
             return "LRU";
         case Policy::Random:
             return "RAND";
+        case Policy::Clock:
+            return "CLOCK";
+        case Policy::Plru:
+            return "PLRU";
+        case Policy::Srrip:
+            return "SRRIP";
+        case Policy::Brrip:
+            return "BRRIP";
+        case Policy::Drrip:
+            return "DRRIP";
+        case Policy::Lfu:
+            return "LFU";
         default:
             std::fprintf(stderr, "Unknown policy\n");
             std::abort();
     }
 }
 
+auto policy_ties_sets(const Policy& policy) -> bool {
+    // one random generator, or one set-dueling selector trained by the leader sets for all the others
+    return policy == Policy::Random || policy == Policy::Drrip;
+}
+
 auto parse_page_size(const std::string& str) -> uint32_t {
-    uint32_t size = str_to_num(str);
-    if (size <= 0 || (size & (size - 1)) != 0) {
+    // a K, M or G suffix scales by 2^10, 2^20 or 2^30
+    static const std::string kUnits = "KMG";
+    auto unit = str.empty() ? std::string::npos : kUnits.find(std::toupper(static_cast<unsigned char>(str.back())));
+    uint32_t size = 0;
+    if (unit == std::string::npos) {
+        uint64_t bytes = str_to_num(str);
+        size = bytes <= UINT32_MAX ? static_cast<uint32_t>(bytes) : 0;
+    } else if (str.size() > 1) {
+        // checked before scaling, the shift would drop the high bits
+        const auto bits = 10 * (unit + 1);
+        uint64_t units = str_to_num(str.substr(0, str.size() - 1));
+        size = units <= (UINT32_MAX >> bits) ? static_cast<uint32_t>(units << bits) : 0;
+    }
+    // a smaller page would leave VPNs reaching into the ASID bits, see tag_page
+    if (size < kMinPageSize || (size & (size - 1)) != 0) {
         std::fprintf(stderr, "Invalid page size: %s\n", str.c_str());
         print_usage(true);
     }
@@ -92,23 +181,73 @@ auto parse_page_size(const std::string& str) -> uint32_t {
 }
 
 auto parse_tlb_size(const std::string& str) -> uint32_t {
-    uint32_t size = str_to_num(str);
-    if (size <= 0) {
+    // a size of 0 disables the level
+    uint64_t size = str_to_num(str);
+    if (size > UINT32_MAX) {
         std::fprintf(stderr, "Invalid tlb size: %s\n", str.c_str());
         print_usage(true);
     }
 
-    return size;
+    return static_cast<uint32_t>(size);
+}
+
+auto parse_ways(const std::string& str) -> uint32_t {
+    uint64_t ways = str_to_num(str);
+    if (ways <= 0 || ways > UINT32_MAX) {
+        std::fprintf(stderr, "Invalid tlb ways: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return static_cast<uint32_t>(ways);
+}
+
+auto parse_sets(const std::string& str) -> uint32_t {
+    uint64_t sets = str_to_num(str);
+    if (sets <= 0 || sets > UINT32_MAX || (sets & (sets - 1)) != 0) {
+        std::fprintf(stderr, "Invalid tlb sets: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return static_cast<uint32_t>(sets);
+}
+
+auto resolve_ways(uint32_t tlb_size, uint32_t ways, uint32_t sets) -> uint32_t {
+    if (tlb_size == 0 || (ways == 0 && sets == 0)) {
+        return 0;
+    }
+
+    // more sets than entries, or sets not dividing them, would leave no whole way to divide by
+    bool valid = ways != 0 || (sets <= tlb_size && tlb_size % sets == 0);
+    if (valid && ways == 0) {
+        ways = tlb_size / sets;
+    }
+
+    uint32_t actual_sets = valid ? tlb_size / ways : 0;
+    valid = valid && tlb_size % ways == 0 && (actual_sets & (actual_sets - 1)) == 0 && (sets == 0 || sets == actual_sets);
+    if (!valid) {
+        std::fprintf(stderr, "Invalid tlb geometry: %u entries, %u ways, %u sets\n", tlb_size, ways, sets);
+        print_usage(true);
+    }
+
+    return actual_sets == 1 ? 0 : ways;
+}
+
+auto ways_to_string(uint32_t tlb_size, uint32_t ways) -> std::string {
+    if (ways == 0) {
+        return "fully associative";
+    } else {
+        return std::to_string(ways) + " ways, " + std::to_string(tlb_size / ways) + " sets";
+    }
 }
 
 auto parse_cost(const std::string& str) -> uint32_t {
-    uint32_t cost = str_to_num(str);
-    if (cost <= 0) {
+    uint64_t cost = str_to_num(str);
+    if (cost <= 0 || cost > UINT32_MAX) {
         std::fprintf(stderr, "Invalid cost: %s\n", str.c_str());
         print_usage(true);
     }
 
-    return cost;
+    return static_cast<uint32_t>(cost);
 }
 
 auto parse_policy(const std::string& policy) -> Policy {
@@ -118,22 +257,105 @@ auto parse_policy(const std::string& policy) -> Policy {
         return Policy::LRU;
     } else if (policy == "RAND") {
         return Policy::Random;
+    } else if (policy == "CLOCK") {
+        return Policy::Clock;
+    } else if (policy == "PLRU") {
+        return Policy::Plru;
+    } else if (policy == "SRRIP") {
+        return Policy::Srrip;
+    } else if (policy == "BRRIP") {
+        return Policy::Brrip;
+    } else if (policy == "DRRIP") {
+        return Policy::Drrip;
+    } else if (policy == "LFU") {
+        return Policy::Lfu;
     } else {
         std::fprintf(stderr, "Invalid policy: %s\n", policy.c_str());
         print_usage(true);
     }
 }
 
-auto parse_addrs(const std::string& addrs) -> std::vector<uint32_t> {
-    auto addresses = std::vector<uint32_t>{};
+auto parse_trace_format(const std::string& format) -> TraceFormat {
+    if (format == "text") {
+        return TraceFormat::Text;
+    } else if (format == "bin") {
+        return TraceFormat::Binary;
+    } else if (format == "bin64") {
+        return TraceFormat::Binary64;
+    } else {
+        std::fprintf(stderr, "Invalid trace format: %s\n", format.c_str());
+        print_usage(true);
+    }
+}
+
+auto parse_log_format(const std::string& format) -> LogFormat {
+    if (format == "csv") {
+        return LogFormat::Csv;
+    } else if (format == "bin") {
+        return LogFormat::Binary;
+    } else {
+        std::fprintf(stderr, "Invalid log format: %s\n", format.c_str());
+        print_usage(true);
+    }
+}
+
+auto parse_seed(const std::string& str) -> uint64_t {
+    char* end = nullptr;
+    uint64_t seed = std::strtoull(str.c_str(), &end, 0);
+    if (str.empty() || *end != '\0') {
+        std::fprintf(stderr, "Invalid seed: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return seed;
+}
+
+auto parse_threads(const std::string& str) -> size_t {
+    uint64_t threads = str_to_num(str);
+    if (threads <= 0 || threads > UINT32_MAX) {
+        std::fprintf(stderr, "Invalid threads: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return static_cast<size_t>(threads);
+}
+
+auto parse_frames(const std::string& str) -> uint32_t {
+    uint64_t frames = str_to_num(str);
+    if (frames > UINT32_MAX) {
+        std::fprintf(stderr, "Invalid frames: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return static_cast<uint32_t>(frames);
+}
+
+auto parse_addrs(const std::string& addrs) -> std::vector<addr_type> {
+    auto addresses = std::vector<addr_type>{};
 
     auto strlist = split_string(addrs, ",");
     for (const auto& str : strlist) {
         if (str.empty()) {
             std::fprintf(stderr, "Invalid address: <empty>. Skipped.\n");
             continue;
+        } else if (str[0] == '@') {
+            // a context switch to the address space of the ASID
+            uint64_t asid = str.size() > 1 ? str_to_num(str.substr(1)) : ~uint64_t{0};
+            if (asid >= (uint64_t{1} << kAsidBits)) {
+                std::fprintf(stderr, "Invalid ASID: %s\n", str.c_str());
+                print_usage(true);
+            }
+            addresses.push_back(context_switch(static_cast<asid_type>(asid)));
+        } else if (str[0] == '!') {
+            // an unmap of the page holding the address
+            addr_type addr = str.size() > 1 ? str_to_num(str.substr(1)) : 0;
+            if (addr <= 0 || addr > kUnmapAddressMask) {
+                std::fprintf(stderr, "Invalid unmap: %s\n", str.c_str());
+                print_usage(true);
+            }
+            addresses.push_back(unmap(addr));
         } else {
-            uint32_t addr = str_to_num(str);
+            addr_type addr = str_to_num(str);
             if (addr <= 0) {
                 std::fprintf(stderr, "Invalid address: %s\n", str.c_str());
                 print_usage(true);
@@ -146,13 +368,19 @@ auto parse_addrs(const std::string& addrs) -> std::vector<uint32_t> {
     return addresses;
 }
 
-auto addrs_to_string(const std::vector<uint32_t>& addrs) -> std::string {
+auto addrs_to_string(const std::vector<addr_type>& addrs) -> std::string {
     if (addrs.empty()) {
         return "<empty>";
     } else {
         std::string result;
         for (const auto& addr : addrs) {
-            result += num_to_str_hex(addr) + ",";
+            if (is_context_switch(addr)) {
+                result += "@" + std::to_string(switch_asid(addr)) + ",";
+            } else if (is_unmap(addr)) {
+                result += "!" + num_to_str_hex(unmap_address(addr)) + ",";
+            } else {
+                result += num_to_str_hex(addr) + ",";
+            }
         }
 
         return result.substr(0, result.length() - 1);
@@ -7,10 +7,19 @@
 #include <string>
 #include <vector>
 
+#include "access_log.h"
+#include "trace.h"
+
 enum class Policy {
     FIFO,
     LRU,
     Random,
+    Clock,
+    Plru,
+    Srrip,
+    Brrip,
+    Drrip,
+    Lfu,
 };
 
 [[noreturn]] auto print_usage(bool onerror) -> void;
@@ -19,20 +28,43 @@ auto split_string(const std::string& s, const std::string& delimiter) -> std::ve
 
 auto begins_with(const std::string& s, const std::string& prefix) -> bool;
 
-auto str_to_num(const std::string& s) -> uint32_t;
+auto str_to_num(const std::string& s) -> uint64_t;
 
-auto num_to_str_hex(uint32_t n) -> std::string;
+auto num_to_str_hex(uint64_t n) -> std::string;
 
 auto policy_to_string(const Policy& policy) -> std::string;
 
+// whether the policy keeps state common to all sets, so that no set can be simulated apart
+auto policy_ties_sets(const Policy& policy) -> bool;
+
 auto parse_page_size(const std::string& str) -> uint32_t;
 
 auto parse_tlb_size(const std::string& str) -> uint32_t;
 
+auto parse_ways(const std::string& str) -> uint32_t;
+
+auto parse_sets(const std::string& str) -> uint32_t;
+
+// ways per set of a TLB given either its ways or its sets, 0 for fully associative
+auto resolve_ways(uint32_t tlb_size, uint32_t ways, uint32_t sets) -> uint32_t;
+
+auto ways_to_string(uint32_t tlb_size, uint32_t ways) -> std::string;
+
 auto parse_cost(const std::string& str) -> uint32_t;
 
 auto parse_policy(const std::string& policy) -> Policy;
 
-auto parse_addrs(const std::string& addrs) -> std::vector<uint32_t>;
+auto parse_trace_format(const std::string& format) -> TraceFormat;
+
+auto parse_log_format(const std::string& format) -> LogFormat;
+
+auto parse_seed(const std::string& str) -> uint64_t;
+
+auto parse_threads(const std::string& str) -> size_t;
+
+// 0 for unlimited memory
+auto parse_frames(const std::string& str) -> uint32_t;
+
+auto parse_addrs(const std::string& addrs) -> std::vector<addr_type>;
 
-auto addrs_to_string(const std::vector<uint32_t>& addrs) -> std::string;
+auto addrs_to_string(const std::vector<addr_type>& addrs) -> std::string;